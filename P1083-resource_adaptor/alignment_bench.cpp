@@ -0,0 +1,111 @@
+// alignment_bench.cpp                                                -*-C++-*-
+
+// Measure the cost of allocating through `resource_adaptor` at each
+// power-of-two alignment from 1 to 4096, including the alignments above
+// `MaxAlignment` that are satisfied by over-allocating and storing a
+// back-offset header.
+//
+// Usage: alignment_bench [ blocks [ rounds [ repeats ] ] ]
+//
+// For each alignment and each of a small (64-byte) and a large (4096-byte)
+// block size, `blocks` (default 1024) blocks are allocated and then
+// deallocated, in order, `rounds` (default 1000) times.  This is repeated
+// `repeats` (default 5) times and the fastest repetition is reported.  Each
+// line of output has the alignment and block size, followed by the mean time
+// in ns for one allocation plus its deallocation through
+// `resource_adaptor<std::allocator<char>>` (with the default `MaxAlignment`
+// of `alignof(max_align_t)`), called through a `memory_resource` pointer, and
+// through the aligned forms of `::operator new` and `::operator delete`, for
+// comparison.
+
+#define RA_SWITCH 1
+
+#include <resource_adaptor.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <vector>
+
+namespace {
+
+template <class Allocate, class Deallocate>
+double nsPerAllocation(std::size_t  blocks,
+                       std::size_t  rounds,
+                       Allocate     allocate,
+                       Deallocate   deallocate)
+    // Return the mean time in ns to allocate a block with `allocate()` and
+    // deallocate it with `deallocate(p)`.
+{
+    std::vector<void*> ptrs(blocks);
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t round = 0; round < rounds; ++round) {
+        for (void *&p : ptrs) {
+            p = allocate();
+        }
+        for (void *p : ptrs) {
+            deallocate(p);
+        }
+    }
+    std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    return elapsed.count() / double(blocks * rounds);
+}
+
+std::size_t parseArg(int argc, char *argv[], int i, std::size_t dflt)
+{
+    if (i >= argc) return dflt;
+    char *end;
+    unsigned long long value = std::strtoull(argv[i], &end, 10);
+    if (*end || 0 == value) {
+        std::cerr << "Usage: alignment_bench [ blocks [ rounds [ repeats ] ] ]"
+                  << std::endl;
+        std::exit(2);
+    }
+    return std::size_t(value);
+}
+
+} // close unnamed namespace
+
+int main(int argc, char *argv[])
+{
+    const std::size_t blocks  = parseArg(argc, argv, 1, 1024);
+    const std::size_t rounds  = parseArg(argc, argv, 2, 1000);
+    const std::size_t repeats = parseArg(argc, argv, 3, 5);
+
+    XPMR::resource_adaptor<std::allocator<char>> adaptor;
+
+    // Hide the dynamic type of the resource so that the compiler cannot
+    // devirtualize the calls.
+    XPMR::memory_resource *volatile opaque_p = &adaptor;
+    XPMR::memory_resource *rsrc = opaque_p;
+
+    std::cout << "alignment,bytes,resource_adaptor,aligned_new" << std::endl;
+
+    for (std::size_t align = 1; align <= 4096; align *= 2) {
+        for (std::size_t bytes : { 64, 4096 }) {
+            double bestAdaptor = 1e300, bestNew = 1e300;
+            for (std::size_t rep = 0; rep < repeats; ++rep) {
+                bestAdaptor = std::min(bestAdaptor, nsPerAllocation(
+                    blocks, rounds,
+                    [=]{ return rsrc->allocate(bytes, align); },
+                    [=](void *p){ rsrc->deallocate(p, bytes, align); }));
+
+                const std::align_val_t al{ align };
+                bestNew = std::min(bestNew, nsPerAllocation(
+                    blocks, rounds,
+                    [=]{ return ::operator new(bytes, al); },
+                    [=](void *p){ ::operator delete(p, bytes, al); }));
+            }
+
+            std::cout << align << ',' << bytes << ','
+                      << std::fixed << std::setprecision(2)
+                      << bestAdaptor << ',' << bestNew << std::endl;
+        }
+    }
+}
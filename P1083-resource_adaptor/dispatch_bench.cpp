@@ -0,0 +1,197 @@
+// dispatch_bench.cpp                                                 -*-C++-*-
+
+// Compare the allocation throughput of the three `resource_adaptor`
+// algorithms for mapping a runtime alignment to a rebound allocator: switch on
+// log2 (`resource_adaptor_switch.h`), linear search
+// (`resource_adaptor_linear.h`), and binary search
+// (`resource_adaptor_binsearch.h`).
+//
+// Usage: dispatch_bench [ blocks [ rounds [ repeats ] ] ]
+//
+// For each combination of an underlying allocator, an alignment distribution,
+// and a size range, a workload of `blocks` (default 1024) random requests is
+// generated.  Each algorithm allocates all of the blocks of the workload in
+// order and then deallocates them in order, `rounds` (default 1000) times.
+// This is repeated `repeats` (default 5) times, interleaving the algorithms,
+// and the fastest repetition of each is reported.  Each line of output has
+// the allocator, alignment distribution, and size range, followed by the mean
+// time in ns for one allocation plus its deallocation for each algorithm.
+//
+// Allocators:
+// * `arena`: a bump allocator whose deallocation is a no-op, so that the time
+//   is dominated by the virtual call and the alignment dispatch
+// * `new`: `std::allocator`, to show the dispatch cost relative to a typical
+//   general-purpose allocator
+//
+// Alignment distributions (`benchMaxAlign` is 256):
+// * `default`: every request uses `alignof(max_align_t)`
+// * `mixed`: powers of two from 1 to `benchMaxAlign`, uniformly distributed
+// * `overaligned`: 90% over-aligned (32 to `benchMaxAlign`), 10% from 1 to
+//   `alignof(max_align_t)`
+//
+// Size ranges: `small` (1-64 bytes), `medium` (65-1024), `large` (1025-16384).
+
+#include "dispatch_bench.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <iterator>
+#include <memory>
+#include <random>
+
+namespace {
+
+struct Algorithm
+{
+    const char *name;
+    double    (*nsPerAllocation)(const Workload&, Arena*);
+};
+
+constexpr Algorithm algorithms[] = {
+    { "switch",    ra_switch::nsPerAllocation    },
+    { "linear",    ra_linear::nsPerAllocation    },
+    { "binsearch", ra_binsearch::nsPerAllocation }
+};
+
+constexpr std::size_t numAlgorithms = std::size(algorithms);
+
+enum class AlignDist { defaultAlign, mixed, overaligned };
+
+struct SizeRange
+{
+    const char  *name;
+    std::size_t  min;
+    std::size_t  max;
+};
+
+constexpr SizeRange sizeRanges[] = {
+    { "small",  1,    64    },
+    { "medium", 65,   1024  },
+    { "large",  1025, 16384 }
+};
+
+const char* alignDistName(AlignDist d)
+{
+    switch (d) {
+        case AlignDist::defaultAlign: return "default";
+        case AlignDist::mixed:        return "mixed";
+        case AlignDist::overaligned:  return "overaligned";
+    }
+    return "?";
+}
+
+std::vector<Request> makeRequests(std::size_t      count,
+                                  AlignDist        dist,
+                                  const SizeRange& sizes,
+                                  std::mt19937&    rengine)
+    // Return `count` random requests with alignments drawn from `dist` and
+    // sizes drawn uniformly from `sizes`.
+{
+    constexpr std::size_t maxAlignLog2 = std::bit_width(benchMaxAlign) - 1;
+    constexpr std::size_t defAlignLog2 =
+        std::bit_width(alignof(max_align_t)) - 1;
+
+    std::uniform_int_distribution<std::size_t> sizeRand(sizes.min, sizes.max);
+    std::uniform_int_distribution<std::size_t> anyLog2(0, maxAlignLog2);
+    std::uniform_int_distribution<std::size_t> overLog2(defAlignLog2 + 1,
+                                                        maxAlignLog2);
+    std::uniform_int_distribution<std::size_t> underLog2(0, defAlignLog2);
+    std::bernoulli_distribution                isOver(0.9);
+
+    std::vector<Request> requests(count);
+    for (Request& req : requests) {
+        req.bytes = sizeRand(rengine);
+        switch (dist) {
+          case AlignDist::defaultAlign:
+            req.alignment = alignof(max_align_t);
+            break;
+          case AlignDist::mixed:
+            req.alignment = std::size_t(1) << anyLog2(rengine);
+            break;
+          case AlignDist::overaligned:
+            req.alignment = std::size_t(1) << (isOver(rengine) ?
+                                               overLog2(rengine) :
+                                               underLog2(rengine));
+            break;
+        }
+    }
+
+    return requests;
+}
+
+std::size_t arenaBytes(const std::vector<Request>& requests)
+    // Return an arena size large enough for one round of `requests`.  Each
+    // block is rounded up to a multiple of its alignment and may be preceded
+    // by up to `alignment - 1` bytes of padding.
+{
+    std::size_t total = 0;
+    for (const Request& req : requests) {
+        total += req.bytes + 2 * req.alignment;
+    }
+    return total;
+}
+
+std::size_t parseArg(int argc, char *argv[], int i, std::size_t dflt)
+{
+    if (i >= argc) return dflt;
+    char *end;
+    unsigned long long value = std::strtoull(argv[i], &end, 10);
+    if (*end || 0 == value) {
+        std::cerr << "Usage: dispatch_bench [ blocks [ rounds [ repeats ] ] ]"
+                  << std::endl;
+        std::exit(2);
+    }
+    return std::size_t(value);
+}
+
+} // close unnamed namespace
+
+int main(int argc, char *argv[])
+{
+    const std::size_t blocks  = parseArg(argc, argv, 1, 1024);
+    const std::size_t rounds  = parseArg(argc, argv, 2, 1000);
+    const std::size_t repeats = parseArg(argc, argv, 3, 5);
+
+    std::mt19937 rengine;  // Default seed, for reproducible workloads
+
+    std::cout << "allocator,alignments,sizes";
+    for (const Algorithm& alg : algorithms) {
+        std::cout << ',' << alg.name;
+    }
+    std::cout << std::endl;
+
+    for (bool useArena : { true, false }) {
+        for (AlignDist dist : { AlignDist::defaultAlign, AlignDist::mixed,
+                                AlignDist::overaligned }) {
+            for (const SizeRange& sizes : sizeRanges) {
+                Workload w{ makeRequests(blocks, dist, sizes, rengine),
+                            rounds };
+
+                std::unique_ptr<Arena> arena;
+                if (useArena)
+                    arena = std::make_unique<Arena>(arenaBytes(w.requests));
+
+                double best[numAlgorithms];
+                std::fill(std::begin(best), std::end(best), 1e300);
+                for (std::size_t rep = 0; rep < repeats; ++rep) {
+                    for (std::size_t a = 0; a < numAlgorithms; ++a) {
+                        best[a] = std::min(best[a],
+                                           algorithms[a].nsPerAllocation(
+                                               w, arena.get()));
+                    }
+                }
+
+                std::cout << (useArena ? "arena" : "new") << ','
+                          << alignDistName(dist) << ',' << sizes.name;
+                for (double ns : best) {
+                    std::cout << ',' << std::fixed << std::setprecision(2)
+                              << ns;
+                }
+                std::cout << std::endl;
+            }
+        }
+    }
+}
@@ -0,0 +1,105 @@
+// dispatch_bench.h                                                   -*-C++-*-
+
+// Declarations shared by the alignment-dispatch benchmark
+// (`dispatch_bench.cpp`) and the three builds of its timing loop
+// (`dispatch_bench_imp.cpp`), one per `resource_adaptor` algorithm.  Each
+// build is compiled with `XSTD` defined to a different namespace, so that the
+// three `resource_adaptor_imp` templates can coexist in one program.
+
+#ifndef INCLUDED_DISPATCH_BENCH_DOT_H
+#define INCLUDED_DISPATCH_BENCH_DOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+// Largest alignment supported by the benchmarked resource adaptors.
+constexpr std::size_t benchMaxAlign = 256;
+
+// One allocation request.
+struct Request
+{
+    std::size_t bytes;
+    std::size_t alignment;
+};
+
+// Sequence of requests that is allocated in order, then deallocated in order,
+// `rounds` times.
+struct Workload
+{
+    std::vector<Request> requests;
+    std::size_t          rounds;
+};
+
+// Bump allocator that isolates the cost of the dispatch from that of the
+// underlying allocator.  Deallocation is a no-op; `reset` reclaims all the
+// memory at once.
+class Arena
+{
+    std::byte   *m_buffer;
+    std::size_t  m_size;
+    std::size_t  m_used = 0;
+
+  public:
+    explicit Arena(std::size_t size)
+        : m_buffer(static_cast<std::byte*>(
+                       ::operator new(size, std::align_val_t(benchMaxAlign))))
+        , m_size(size) { }
+
+    ~Arena() { ::operator delete(m_buffer, std::align_val_t(benchMaxAlign)); }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(std::size_t bytes, std::size_t alignment) {
+        std::size_t start = (m_used + alignment - 1) & ~(alignment - 1);
+        if (start + bytes > m_size) throw std::bad_alloc();
+        m_used = start + bytes;
+        return m_buffer + start;
+    }
+
+    void reset() { m_used = 0; }
+};
+
+// STL allocator over an `Arena`.
+template <class Tp>
+class ArenaAllocator
+{
+    Arena *m_arena_p;
+
+  public:
+    typedef Tp value_type;
+
+    explicit ArenaAllocator(Arena *arena_p) : m_arena_p(arena_p) { }
+
+    template <class T>
+    ArenaAllocator(const ArenaAllocator<T>& other)
+        : m_arena_p(other.arena()) { }
+
+    Tp* allocate(std::size_t n)
+        { return static_cast<Tp*>(m_arena_p->allocate(n * sizeof(Tp),
+                                                      alignof(Tp))); }
+
+    void deallocate(Tp*, std::size_t) { }
+
+    Arena *arena() const { return m_arena_p; }
+};
+
+template <class Tp1, class Tp2>
+bool operator==(const ArenaAllocator<Tp1>& a, const ArenaAllocator<Tp2>& b)
+{
+    return a.arena() == b.arena();
+}
+
+// Each of these returns the mean time in ns to allocate and deallocate one
+// block of `w` through a `resource_adaptor` for `ArenaAllocator` over
+// `*arena_p` (which must be large enough for all the requests of `w`) or, if
+// `arena_p` is null, for `std::allocator`.  The allocations are made through
+// a pointer to the `memory_resource` base class, as a pmr container would
+// make them.
+namespace ra_switch    { double nsPerAllocation(const Workload&, Arena*); }
+namespace ra_linear    { double nsPerAllocation(const Workload&, Arena*); }
+namespace ra_binsearch { double nsPerAllocation(const Workload&, Arena*); }
+
+#endif // ! defined(INCLUDED_DISPATCH_BENCH_DOT_H)
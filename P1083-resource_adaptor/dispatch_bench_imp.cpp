@@ -0,0 +1,61 @@
+// dispatch_bench_imp.cpp                                             -*-C++-*-
+
+// Timing loop of the alignment-dispatch benchmark.  This file is compiled once
+// per `resource_adaptor` algorithm, with one of `RA_SWITCH`, `RA_LINEAR`, or
+// `RA_BINARY_SEARCH` defined and with `XSTD` defined to the namespace
+// (`ra_switch`, `ra_linear`, or `ra_binsearch`) declared for that algorithm
+// in `dispatch_bench.h`.
+
+#include "dispatch_bench.h"
+#include <resource_adaptor.h>
+
+#include <chrono>
+#include <memory>
+
+namespace {
+
+double timeWorkload(XPMR::memory_resource *resource_p, const Workload& w,
+                    Arena *arena_p)
+    // Return the mean time in ns to allocate and deallocate one block of `w`
+    // from `*resource_p`, resetting `*arena_p` (if not null) after each round.
+{
+    // Hide the dynamic type of the resource so that the compiler cannot
+    // devirtualize the calls.
+    XPMR::memory_resource *volatile opaque_p = resource_p;
+    XPMR::memory_resource *rsrc = opaque_p;
+
+    const std::size_t  n = w.requests.size();
+    std::vector<void*> blocks(n);
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t round = 0; round < w.rounds; ++round) {
+        for (std::size_t i = 0; i < n; ++i) {
+            const Request& req = w.requests[i];
+            blocks[i] = rsrc->allocate(req.bytes, req.alignment);
+        }
+        for (std::size_t i = 0; i < n; ++i) {
+            const Request& req = w.requests[i];
+            rsrc->deallocate(blocks[i], req.bytes, req.alignment);
+        }
+        if (arena_p) arena_p->reset();
+    }
+    std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    return elapsed.count() / double(n * w.rounds);
+}
+
+} // close unnamed namespace
+
+double XSTD::nsPerAllocation(const Workload& w, Arena *arena_p)
+{
+    if (arena_p) {
+        XPMR::resource_adaptor<ArenaAllocator<char>, benchMaxAlign>
+            resource(ArenaAllocator<char>{arena_p});
+        return timeWorkload(&resource, w, arena_p);
+    }
+    else {
+        XPMR::resource_adaptor<std::allocator<char>, benchMaxAlign> resource;
+        return timeWorkload(&resource, w, nullptr);
+    }
+}
@@ -46,6 +46,22 @@ class memory_resource
     void  deallocate(void *p, size_t bytes, size_t alignment = 0)
         { do_deallocate(p, bytes, alignment); }
 
+    // Allocate 'count' separate blocks, each of the specified 'bytes' and
+    // 'alignment', storing them in 'out[0]' through 'out[count - 1]'.  Each
+    // block can be deallocated individually with 'deallocate' or as part of
+    // a batch with 'deallocate_n'.  If an exception is thrown, no blocks
+    // remain allocated.
+    void allocate_n(size_t count, size_t bytes, size_t alignment,
+                    void *out[])
+        { do_allocate_n(count, bytes, alignment, out); }
+
+    // Deallocate the 'count' blocks 'blocks[0]' through 'blocks[count - 1]',
+    // each of which was allocated, individually or in a batch, with the
+    // specified 'bytes' and 'alignment'.
+    void deallocate_n(void *const blocks[], size_t count, size_t bytes,
+                      size_t alignment = 0)
+        { do_deallocate_n(blocks, count, bytes, alignment); }
+
     // 'is_equal' is needed because polymorphic allocators are sometimes
     // produced as a result of type erasure.  In that case, two different
     // instances of a polymorphic_memory_resource may actually represent
@@ -58,6 +74,13 @@ class memory_resource
     virtual void* do_allocate(size_t bytes, size_t alignment) = 0;
     virtual void  do_deallocate(void *p, size_t bytes, size_t alignment) = 0;
     virtual bool do_is_equal(const memory_resource& other) const = 0;
+
+    // The default batch operations call 'do_allocate' and 'do_deallocate'
+    // once per block.  Override them to amortize per-call costs.
+    virtual void do_allocate_n(size_t count, size_t bytes, size_t alignment,
+                               void *out[]);
+    virtual void do_deallocate_n(void *const blocks[], size_t count,
+                                 size_t bytes, size_t alignment);
 };
 
 inline
@@ -89,6 +112,21 @@ class resource_adaptor_imp : public memory_resource
     template <size_t Align>
     void aligned_deallocate(void *p, size_t bytes);
 
+    template <size_t Align>
+    void aligned_allocate_n(size_t count, size_t bytes, void *out[]);
+
+    template <size_t Align>
+    void aligned_deallocate_n(void *const blocks[], size_t count,
+                              size_t bytes);
+
+    // Call 'op(integral_constant<size_t, Align>())' for the power of 2
+    // 'Align' equal to 'alignment' (or to the natural alignment of 'bytes' if
+    // 'alignment' is 0), and return its result.  Throw 'bad_alloc' if the
+    // alignment is not a power of 2 or exceeds 'MaxAlignment'.
+    template <class Op>
+    static auto dispatch_alignment(size_t bytes, size_t alignment, Op op)
+        -> decltype(op(integral_constant<size_t, 1>()));
+
   public:
     typedef Allocator allocator_type;
 
@@ -103,10 +141,25 @@ class resource_adaptor_imp : public memory_resource
 
     allocator_type get_allocator() const { return m_alloc; }
 
+    // Non-virtual equivalents of 'allocate(bytes, Align)' and
+    // 'deallocate(p, bytes, Align)' for an alignment known at compile time,
+    // used by 'static_resource_allocator'.  Blocks from either interface can
+    // be deallocated through the other.
+    template <size_t Align>
+    void *allocate_aligned(size_t bytes);
+    template <size_t Align>
+    void deallocate_aligned(void *p, size_t bytes);
+
   private:
     virtual void *do_allocate(size_t bytes, size_t alignment);
     virtual void do_deallocate(void *p, size_t bytes, size_t alignment);
 
+    // Dispatch on 'alignment' and rebind the allocator once per batch.
+    virtual void do_allocate_n(size_t count, size_t bytes, size_t alignment,
+                               void *out[]);
+    virtual void do_deallocate_n(void *const blocks[], size_t count,
+                                 size_t bytes, size_t alignment);
+
     virtual bool do_is_equal(const memory_resource& other) const;
 };
 
@@ -154,6 +207,11 @@ class polymorphic_allocator
     Tp *allocate(size_t n);
     void deallocate(Tp *p, size_t n);
 
+    // Allocate 'count' separate objects, storing pointers to them in
+    // 'out[0]' through 'out[count - 1]', using 'resource()->allocate_n'.
+    void allocate_n(size_t count, Tp *out[]);
+    void deallocate_n(Tp *const ps[], size_t count);
+
     void* allocate_bytes(size_t nbytes,
                          size_t alignment = alignof(max_align_t));
     void deallocate_bytes(void* p, size_t nbytes,
@@ -199,6 +257,103 @@ template <class T1, class T2>
 bool operator!=(const polymorphic_allocator<T1>& a,
                 const polymorphic_allocator<T2>& b);
 
+// Customization point through which 'static_resource_allocator' calls a
+// resource whose type, 'Resource', is known at compile time.  The primary
+// template calls the public interface of 'memory_resource', which the
+// compiler can devirtualize only if 'Resource' is 'final'.  Specializations
+// call a non-virtual path of the resource instead.
+template <class Resource>
+struct static_resource_traits
+{
+    template <size_t Align>
+    static void *allocate(Resource *r, size_t bytes)
+        { return r->allocate(bytes, Align); }
+
+    template <size_t Align>
+    static void deallocate(Resource *r, void *p, size_t bytes)
+        { r->deallocate(p, bytes, Align); }
+};
+
+template <class Allocator, size_t MaxAlignment>
+struct static_resource_traits<resource_adaptor_imp<Allocator, MaxAlignment>>
+{
+    typedef resource_adaptor_imp<Allocator, MaxAlignment> resource_type;
+
+    template <size_t Align>
+    static void *allocate(resource_type *r, size_t bytes)
+        { return r->template allocate_aligned<Align>(bytes); }
+
+    template <size_t Align>
+    static void deallocate(resource_type *r, void *p, size_t bytes)
+        { r->template deallocate_aligned<Align>(p, bytes); }
+};
+
+// STL allocator that holds a pointer to a resource of the concrete type
+// 'Resource' (derived from 'memory_resource') and allocates through
+// 'static_resource_traits<Resource>', avoiding the indirect call made by
+// 'polymorphic_allocator' for every allocation.  It converts to
+// 'polymorphic_allocator' and compares equal to a 'polymorphic_allocator'
+// for an equal resource; memory allocated through either can be deallocated
+// through the other.  'construct' passes a 'polymorphic_allocator' for the
+// same resource to elements that use allocators, so that they can be
+// ordinary 'pmr' types.
+template <class Tp, class Resource>
+class static_resource_allocator
+{
+    Resource *m_resource;
+
+  public:
+    typedef Tp       value_type;
+    typedef Resource resource_type;
+
+    template <typename U>
+    struct rebind { typedef static_resource_allocator<U, Resource> other; };
+
+    static_resource_allocator(Resource *r);
+
+    template <class U>
+    static_resource_allocator(const static_resource_allocator<U, Resource>&
+                              other);
+
+    Tp *allocate(size_t n);
+    void deallocate(Tp *p, size_t n);
+
+    template <typename T, typename... Args>
+      void construct(T* p, Args&&... args);
+
+    template <typename T>
+      void destroy(T* p);
+
+    template <class U>
+    operator polymorphic_allocator<U>() const;
+
+    Resource *resource() const;
+};
+
+template <class T1, class T2, class Resource>
+bool operator==(const static_resource_allocator<T1, Resource>& a,
+                const static_resource_allocator<T2, Resource>& b);
+
+template <class T1, class T2, class Resource>
+bool operator!=(const static_resource_allocator<T1, Resource>& a,
+                const static_resource_allocator<T2, Resource>& b);
+
+template <class T1, class T2, class Resource>
+bool operator==(const static_resource_allocator<T1, Resource>& a,
+                const polymorphic_allocator<T2>& b);
+
+template <class T1, class T2, class Resource>
+bool operator==(const polymorphic_allocator<T1>& a,
+                const static_resource_allocator<T2, Resource>& b);
+
+template <class T1, class T2, class Resource>
+bool operator!=(const static_resource_allocator<T1, Resource>& a,
+                const polymorphic_allocator<T2>& b);
+
+template <class T1, class T2, class Resource>
+bool operator!=(const polymorphic_allocator<T1>& a,
+                const static_resource_allocator<T2, Resource>& b);
+
 namespace __details {
 
 template <size_t Align> struct aligned_chunk;
@@ -238,6 +393,29 @@ pmr::memory_resource::~memory_resource()
 {
 }
 
+inline
+void pmr::memory_resource::do_allocate_n(size_t count, size_t bytes,
+                                         size_t alignment, void *out[])
+{
+    size_t i = 0;
+    try {
+        for (; i < count; ++i)
+            out[i] = do_allocate(bytes, alignment);
+    }
+    catch (...) {
+        do_deallocate_n(out, i, bytes, alignment);
+        throw;
+    }
+}
+
+inline
+void pmr::memory_resource::do_deallocate_n(void *const blocks[], size_t count,
+                                           size_t bytes, size_t alignment)
+{
+    for (size_t i = 0; i < count; ++i)
+        do_deallocate(blocks[i], bytes, alignment);
+}
+
 inline
 pmr::memory_resource *
 pmr::get_default_resource()
@@ -301,96 +479,81 @@ aligned_deallocate(void *p, size_t  bytes)
 }
 
 template <class Allocator, size_t MaxAlignment>
-void *pmr::resource_adaptor_imp<Allocator, MaxAlignment>::
-do_allocate(size_t bytes, size_t alignment)
+template <size_t Align>
+void pmr::resource_adaptor_imp<Allocator, MaxAlignment>::
+aligned_allocate_n(size_t count, size_t bytes, void *out[])
 {
-    if (0 == alignment) {
-        // Choose natural alignment for 'bytes'
-        alignment = ((bytes ^ (bytes - 1)) >> 1) + 1;
-        if (alignment > MaxAlignment)
-            alignment = MaxAlignment;
+    typedef __details::aligned_chunk<Align> chunk;
+    size_t chunks = (bytes + Align - 1) / Align;
+
+    typedef typename allocator_traits<Allocator>::
+        template rebind_traits<chunk> chunk_traits;
+    typename chunk_traits::allocator_type rebound(m_alloc);
+
+    size_t i = 0;
+    try {
+        for (; i < count; ++i)
+            out[i] = chunk_traits::allocate(rebound, chunks);
+    }
+    catch (...) {
+        while (i > 0) {
+            --i;
+            chunk_traits::deallocate(rebound, static_cast<chunk*>(out[i]),
+                                     chunks);
+        }
+        throw;
     }
+}
 
-#define ALLOC_CASE(n) \
-    case (1ULL << (n)): if constexpr (MaxAlignment <= (1ULL << (n)))      \
-        return aligned_allocate<(1ULL << (n))>(bytes)
+template <class Allocator, size_t MaxAlignment>
+template <size_t Align>
+void pmr::resource_adaptor_imp<Allocator, MaxAlignment>::
+aligned_deallocate_n(void *const blocks[], size_t count, size_t bytes)
+{
+    typedef __details::aligned_chunk<Align> chunk;
+    size_t chunks = (bytes + Align - 1) / Align;
 
-    switch (alignment) {
-        ALLOC_CASE(0);
-        ALLOC_CASE(1);
-        ALLOC_CASE(2);
-        ALLOC_CASE(3);
-        ALLOC_CASE(4);
-        ALLOC_CASE(5);
-        ALLOC_CASE(6);
-        ALLOC_CASE(7);
-        ALLOC_CASE(8);
-        ALLOC_CASE(9);
-        ALLOC_CASE(10);
-        ALLOC_CASE(11);
-        ALLOC_CASE(12);
-        ALLOC_CASE(13);
-        ALLOC_CASE(14);
-        ALLOC_CASE(15);
-        ALLOC_CASE(16);
-        ALLOC_CASE(17);
-        ALLOC_CASE(18);
-        ALLOC_CASE(19);
-        ALLOC_CASE(20);
-        ALLOC_CASE(21);
-        ALLOC_CASE(22);
-        ALLOC_CASE(23);
-        ALLOC_CASE(24);
-        ALLOC_CASE(25);
-        ALLOC_CASE(26);
-        ALLOC_CASE(27);
-        ALLOC_CASE(28);
-        ALLOC_CASE(29);
-        ALLOC_CASE(30);
-        ALLOC_CASE(31);
-        ALLOC_CASE(32);
-        ALLOC_CASE(33);
-        ALLOC_CASE(34);
-        ALLOC_CASE(35);
-        ALLOC_CASE(36);
-        ALLOC_CASE(37);
-        ALLOC_CASE(38);
-        ALLOC_CASE(39);
-        ALLOC_CASE(40);
-        ALLOC_CASE(41);
-        ALLOC_CASE(42);
-        ALLOC_CASE(43);
-        ALLOC_CASE(44);
-        ALLOC_CASE(45);
-        ALLOC_CASE(46);
-        ALLOC_CASE(47);
-        ALLOC_CASE(48);
-        ALLOC_CASE(49);
-        ALLOC_CASE(50);
-        ALLOC_CASE(51);
-        ALLOC_CASE(52);
-        ALLOC_CASE(53);
-        ALLOC_CASE(54);
-        ALLOC_CASE(55);
-        ALLOC_CASE(56);
-        ALLOC_CASE(57);
-        ALLOC_CASE(58);
-        ALLOC_CASE(59);
-        ALLOC_CASE(60);
-        ALLOC_CASE(61);
-        ALLOC_CASE(62);
-        ALLOC_CASE(63);
-        default:
-            throw bad_alloc{};
-    } // end switch
+    typedef typename allocator_traits<Allocator>::
+        template rebind_traits<chunk> chunk_traits;
+    typename chunk_traits::allocator_type rebound(m_alloc);
 
-#undef ALLOC_CASE
+    for (size_t i = 0; i < count; ++i)
+        chunk_traits::deallocate(rebound, static_cast<chunk*>(blocks[i]),
+                                 chunks);
+}
+
+template <class Allocator, size_t MaxAlignment>
+template <size_t Align>
+inline
+void *pmr::resource_adaptor_imp<Allocator, MaxAlignment>::
+allocate_aligned(size_t bytes)
+{
+    static_assert(0 == (Align & (Align - 1)), "Alignment must be power of 2");
 
+    // Over-aligned requests fail, as they do through 'allocate'.
+    if constexpr (Align <= MaxAlignment)
+        return aligned_allocate<Align>(bytes);
+    else
+        throw bad_alloc{};
 }
 
 template <class Allocator, size_t MaxAlignment>
+template <size_t Align>
+inline
 void pmr::resource_adaptor_imp<Allocator, MaxAlignment>::
-do_deallocate(void *p, size_t  bytes, size_t  alignment)
+deallocate_aligned(void *p, size_t bytes)
+{
+    static_assert(0 == (Align & (Align - 1)), "Alignment must be power of 2");
+
+    if constexpr (Align <= MaxAlignment)
+        aligned_deallocate<Align>(p, bytes);
+}
+
+template <class Allocator, size_t MaxAlignment>
+template <class Op>
+auto pmr::resource_adaptor_imp<Allocator, MaxAlignment>::
+dispatch_alignment(size_t bytes, size_t alignment, Op op)
+    -> decltype(op(integral_constant<size_t, 1>()))
 {
     if (0 == alignment) {
         // Choose natural alignment for 'bytes'
@@ -399,80 +562,117 @@ do_deallocate(void *p, size_t  bytes, size_t  alignment)
             alignment = MaxAlignment;
     }
 
-#define DEALLOC_CASE(n) \
-    case (1ULL << (n)): if constexpr (MaxAlignment <= (1ULL << (n)))      \
-        return aligned_deallocate<(1ULL << (n))>(bytes)
+#define ALIGN_CASE(n) \
+    case (1ULL << (n)): if constexpr ((1ULL << (n)) <= MaxAlignment)      \
+        return op(integral_constant<size_t, (1ULL << (n))>())
 
     switch (alignment) {
-        DEALLOC_CASE(0);
-        DEALLOC_CASE(1);
-        DEALLOC_CASE(2);
-        DEALLOC_CASE(3);
-        DEALLOC_CASE(4);
-        DEALLOC_CASE(5);
-        DEALLOC_CASE(6);
-        DEALLOC_CASE(7);
-        DEALLOC_CASE(8);
-        DEALLOC_CASE(9);
-        DEALLOC_CASE(10);
-        DEALLOC_CASE(11);
-        DEALLOC_CASE(12);
-        DEALLOC_CASE(13);
-        DEALLOC_CASE(14);
-        DEALLOC_CASE(15);
-        DEALLOC_CASE(16);
-        DEALLOC_CASE(17);
-        DEALLOC_CASE(18);
-        DEALLOC_CASE(19);
-        DEALLOC_CASE(20);
-        DEALLOC_CASE(21);
-        DEALLOC_CASE(22);
-        DEALLOC_CASE(23);
-        DEALLOC_CASE(24);
-        DEALLOC_CASE(25);
-        DEALLOC_CASE(26);
-        DEALLOC_CASE(27);
-        DEALLOC_CASE(28);
-        DEALLOC_CASE(29);
-        DEALLOC_CASE(30);
-        DEALLOC_CASE(31);
-        DEALLOC_CASE(32);
-        DEALLOC_CASE(33);
-        DEALLOC_CASE(34);
-        DEALLOC_CASE(35);
-        DEALLOC_CASE(36);
-        DEALLOC_CASE(37);
-        DEALLOC_CASE(38);
-        DEALLOC_CASE(39);
-        DEALLOC_CASE(40);
-        DEALLOC_CASE(41);
-        DEALLOC_CASE(42);
-        DEALLOC_CASE(43);
-        DEALLOC_CASE(44);
-        DEALLOC_CASE(45);
-        DEALLOC_CASE(46);
-        DEALLOC_CASE(47);
-        DEALLOC_CASE(48);
-        DEALLOC_CASE(49);
-        DEALLOC_CASE(50);
-        DEALLOC_CASE(51);
-        DEALLOC_CASE(52);
-        DEALLOC_CASE(53);
-        DEALLOC_CASE(54);
-        DEALLOC_CASE(55);
-        DEALLOC_CASE(56);
-        DEALLOC_CASE(57);
-        DEALLOC_CASE(58);
-        DEALLOC_CASE(59);
-        DEALLOC_CASE(60);
-        DEALLOC_CASE(61);
-        DEALLOC_CASE(62);
-        DEALLOC_CASE(63);
+        ALIGN_CASE(0);
+        ALIGN_CASE(1);
+        ALIGN_CASE(2);
+        ALIGN_CASE(3);
+        ALIGN_CASE(4);
+        ALIGN_CASE(5);
+        ALIGN_CASE(6);
+        ALIGN_CASE(7);
+        ALIGN_CASE(8);
+        ALIGN_CASE(9);
+        ALIGN_CASE(10);
+        ALIGN_CASE(11);
+        ALIGN_CASE(12);
+        ALIGN_CASE(13);
+        ALIGN_CASE(14);
+        ALIGN_CASE(15);
+        ALIGN_CASE(16);
+        ALIGN_CASE(17);
+        ALIGN_CASE(18);
+        ALIGN_CASE(19);
+        ALIGN_CASE(20);
+        ALIGN_CASE(21);
+        ALIGN_CASE(22);
+        ALIGN_CASE(23);
+        ALIGN_CASE(24);
+        ALIGN_CASE(25);
+        ALIGN_CASE(26);
+        ALIGN_CASE(27);
+        ALIGN_CASE(28);
+        ALIGN_CASE(29);
+        ALIGN_CASE(30);
+        ALIGN_CASE(31);
+        ALIGN_CASE(32);
+        ALIGN_CASE(33);
+        ALIGN_CASE(34);
+        ALIGN_CASE(35);
+        ALIGN_CASE(36);
+        ALIGN_CASE(37);
+        ALIGN_CASE(38);
+        ALIGN_CASE(39);
+        ALIGN_CASE(40);
+        ALIGN_CASE(41);
+        ALIGN_CASE(42);
+        ALIGN_CASE(43);
+        ALIGN_CASE(44);
+        ALIGN_CASE(45);
+        ALIGN_CASE(46);
+        ALIGN_CASE(47);
+        ALIGN_CASE(48);
+        ALIGN_CASE(49);
+        ALIGN_CASE(50);
+        ALIGN_CASE(51);
+        ALIGN_CASE(52);
+        ALIGN_CASE(53);
+        ALIGN_CASE(54);
+        ALIGN_CASE(55);
+        ALIGN_CASE(56);
+        ALIGN_CASE(57);
+        ALIGN_CASE(58);
+        ALIGN_CASE(59);
+        ALIGN_CASE(60);
+        ALIGN_CASE(61);
+        ALIGN_CASE(62);
+        ALIGN_CASE(63);
         default:
             throw bad_alloc{};
     } // end switch
 
-#undef DEALLOC_CASE
+#undef ALIGN_CASE
+}
+
+template <class Allocator, size_t MaxAlignment>
+void *pmr::resource_adaptor_imp<Allocator, MaxAlignment>::
+do_allocate(size_t bytes, size_t alignment)
+{
+    return dispatch_alignment(bytes, alignment, [&](auto align) {
+        return this->template aligned_allocate<align()>(bytes);
+    });
+}
+
+template <class Allocator, size_t MaxAlignment>
+void pmr::resource_adaptor_imp<Allocator, MaxAlignment>::
+do_deallocate(void *p, size_t  bytes, size_t  alignment)
+{
+    dispatch_alignment(bytes, alignment, [&](auto align) {
+        this->template aligned_deallocate<align()>(p, bytes);
+    });
+}
+
+template <class Allocator, size_t MaxAlignment>
+void pmr::resource_adaptor_imp<Allocator, MaxAlignment>::
+do_allocate_n(size_t count, size_t bytes, size_t alignment, void *out[])
+{
+    dispatch_alignment(bytes, alignment, [&](auto align) {
+        this->template aligned_allocate_n<align()>(count, bytes, out);
+    });
+}
+
+template <class Allocator, size_t MaxAlignment>
+void pmr::resource_adaptor_imp<Allocator, MaxAlignment>::
+do_deallocate_n(void *const blocks[], size_t count, size_t bytes,
+                size_t alignment)
+{
+    dispatch_alignment(bytes, alignment, [&](auto align) {
+        this->template aligned_deallocate_n<align()>(blocks, count, bytes);
+    });
 }
 
 template <class Allocator, size_t MaxAlignment>
@@ -526,6 +726,44 @@ void pmr::polymorphic_allocator<Tp>::deallocate(Tp *p, size_t n)
     m_resource->deallocate(p, n * sizeof(Tp), alignof(Tp));
 }
 
+template <class Tp>
+void pmr::polymorphic_allocator<Tp>::allocate_n(size_t count, Tp *out[])
+{
+    // The resource traffics in 'void*', so the blocks are passed through a
+    // local buffer rather than by aliasing 'out' as an array of 'void*'.
+    const size_t batch = 32;
+    void *blocks[batch];
+
+    size_t done = 0;
+    try {
+        while (done < count) {
+            size_t n = count - done < batch ? count - done : batch;
+            m_resource->allocate_n(n, sizeof(Tp), alignof(Tp), blocks);
+            for (size_t i = 0; i < n; ++i)
+                out[done++] = static_cast<Tp*>(blocks[i]);
+        }
+    }
+    catch (...) {
+        deallocate_n(out, done);
+        throw;
+    }
+}
+
+template <class Tp>
+void pmr::polymorphic_allocator<Tp>::deallocate_n(Tp *const ps[],
+                                                  size_t count)
+{
+    const size_t batch = 32;
+    void *blocks[batch];
+
+    for (size_t done = 0; done < count; ) {
+        size_t n = count - done < batch ? count - done : batch;
+        for (size_t i = 0; i < n; ++i)
+            blocks[i] = ps[done++];
+        m_resource->deallocate_n(blocks, n, sizeof(Tp), alignof(Tp));
+    }
+}
+
 template <class Tp> inline
 void* pmr::polymorphic_allocator<Tp>::allocate_bytes(size_t nbytes,
                                                      size_t alignment)
@@ -694,6 +932,121 @@ bool pmr::operator!=(const pmr::polymorphic_allocator<T1>& a,
     return *a.resource() != *b.resource();
 }
 
+template <class Tp, class Resource>
+inline
+pmr::static_resource_allocator<Tp, Resource>::
+static_resource_allocator(Resource *r)
+    : m_resource(r)
+{
+}
+
+template <class Tp, class Resource>
+    template <class U>
+inline
+pmr::static_resource_allocator<Tp, Resource>::static_resource_allocator(
+    const pmr::static_resource_allocator<U, Resource>& other)
+    : m_resource(other.resource())
+{
+}
+
+template <class Tp, class Resource>
+inline
+Tp *pmr::static_resource_allocator<Tp, Resource>::allocate(size_t n)
+{
+    return static_cast<Tp*>(static_resource_traits<Resource>::
+        template allocate<alignof(Tp)>(m_resource, n * sizeof(Tp)));
+}
+
+template <class Tp, class Resource>
+inline
+void pmr::static_resource_allocator<Tp, Resource>::deallocate(Tp *p, size_t n)
+{
+    static_resource_traits<Resource>::
+        template deallocate<alignof(Tp)>(m_resource, p, n * sizeof(Tp));
+}
+
+template <class Tp, class Resource>
+template <typename T, typename... Args>
+inline
+void pmr::static_resource_allocator<Tp, Resource>::construct(T* p,
+                                                             Args&&... args)
+{
+    polymorphic_allocator<Tp>(m_resource).construct(
+        p, std::forward<Args>(args)...);
+}
+
+template <class Tp, class Resource>
+template <typename T>
+inline
+void pmr::static_resource_allocator<Tp, Resource>::destroy(T* p)
+{
+    p->~T();
+}
+
+template <class Tp, class Resource>
+    template <class U>
+inline
+pmr::static_resource_allocator<Tp, Resource>::
+operator pmr::polymorphic_allocator<U>() const
+{
+    return pmr::polymorphic_allocator<U>(m_resource);
+}
+
+template <class Tp, class Resource>
+inline
+Resource *pmr::static_resource_allocator<Tp, Resource>::resource() const
+{
+    return m_resource;
+}
+
+template <class T1, class T2, class Resource>
+inline
+bool pmr::operator==(const pmr::static_resource_allocator<T1, Resource>& a,
+                     const pmr::static_resource_allocator<T2, Resource>& b)
+{
+    return *a.resource() == *b.resource();
+}
+
+template <class T1, class T2, class Resource>
+inline
+bool pmr::operator!=(const pmr::static_resource_allocator<T1, Resource>& a,
+                     const pmr::static_resource_allocator<T2, Resource>& b)
+{
+    return *a.resource() != *b.resource();
+}
+
+template <class T1, class T2, class Resource>
+inline
+bool pmr::operator==(const pmr::static_resource_allocator<T1, Resource>& a,
+                     const pmr::polymorphic_allocator<T2>& b)
+{
+    return *a.resource() == *b.resource();
+}
+
+template <class T1, class T2, class Resource>
+inline
+bool pmr::operator==(const pmr::polymorphic_allocator<T1>& a,
+                     const pmr::static_resource_allocator<T2, Resource>& b)
+{
+    return *a.resource() == *b.resource();
+}
+
+template <class T1, class T2, class Resource>
+inline
+bool pmr::operator!=(const pmr::static_resource_allocator<T1, Resource>& a,
+                     const pmr::polymorphic_allocator<T2>& b)
+{
+    return *a.resource() != *b.resource();
+}
+
+template <class T1, class T2, class Resource>
+inline
+bool pmr::operator!=(const pmr::polymorphic_allocator<T1>& a,
+                     const pmr::static_resource_allocator<T2, Resource>& b)
+{
+    return *a.resource() != *b.resource();
+}
+
 END_NAMESPACE_XSTD
 
 #endif // ! defined(INCLUDED_POLYMORPHIC_ALLOCATOR_DOT_H)
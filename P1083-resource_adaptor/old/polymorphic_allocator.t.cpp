@@ -12,6 +12,7 @@
 #include <cstdlib>
 #include <climits>
 #include <cstring>
+#include <vector>
 
 BEGIN_NAMESPACE_XSTD
 namespace pmr {
@@ -695,6 +696,166 @@ int main(int argc, char *argv[])
 #define PMR XSTD::pmr::polymorphic_allocator
 
     switch (test) { case 0: // Do all cases for test-case 0
+      case 4:
+      {
+        // --------------------------------------------------------------------
+        // STATIC RESOURCE ALLOCATOR
+        // --------------------------------------------------------------------
+
+        std::cout << "\nSTATIC RESOURCE ALLOCATOR"
+                  << "\n=========================" << std::endl;
+
+        typedef resource_adaptor<SimpleAllocator<char>> Adaptor;
+
+        {
+            // Allocation through the non-virtual path of 'resource_adaptor'
+            AllocCounters xc;
+            SimpleAllocator<char> sax(&xc);
+            Adaptor crx(sax);
+            static_resource_allocator<double, Adaptor> a(&crx);
+            ASSERT(&crx == a.resource());
+
+            double *p = a.allocate(3);
+            ASSERT(1 == xc.blocks_outstanding());
+            ASSERT(int(3 * sizeof(double)) == xc.bytes_outstanding());
+            ASSERT(0 == reinterpret_cast<std::uintptr_t>(p) % alignof(double));
+            a.deallocate(p, 3);
+            ASSERT(0 == xc.blocks_outstanding());
+
+            // Interchangeable with 'polymorphic_allocator'
+            PMR<int> pa = a;
+            ASSERT(&crx == pa.resource());
+            ASSERT(a == pa);
+            ASSERT(pa == a);
+            ASSERT(! (a != pa));
+            static_resource_allocator<char, Adaptor> ac(a);
+            ASSERT(ac == a);
+
+            p = a.allocate(2);
+            PMR<double>(a).deallocate(p, 2);
+            ASSERT(0 == xc.blocks_outstanding());
+            p = PMR<double>(a).allocate(2);
+            a.deallocate(p, 2);
+            ASSERT(0 == xc.blocks_outstanding());
+
+            // Unequal resources
+            AllocCounters yc;
+            Adaptor drx{SimpleAllocator<char>(&yc)};
+            static_resource_allocator<double, Adaptor> b(&drx);
+            ASSERT(a != b);
+            ASSERT(PMR<int>(b) != a);
+            ASSERT(PMR<int>(&drx) == b);
+
+            // Over-aligned requests fail, as through 'allocate'
+            bool caught = false;
+            try {
+                crx.allocate_aligned<2 * alignof(max_align_t)>(8);
+            }
+            catch (const std::bad_alloc&) {
+                caught = true;
+            }
+            ASSERT(caught);
+            ASSERT(0 == xc.blocks_outstanding());
+        }
+
+        {
+            // Resources without a specialized 'static_resource_traits' are
+            // called through 'memory_resource'.
+            TestResource tr;
+            static_resource_allocator<int, TestResource> a(&tr);
+            int *p = a.allocate(5);
+            ASSERT(1 == tr.counters().blocks_outstanding());
+            ASSERT(int(5 * sizeof(int)) == tr.counters().bytes_outstanding());
+            a.deallocate(p, 5);
+            ASSERT(0 == tr.counters().blocks_outstanding());
+        }
+
+        {
+            // Use in a container of 'pmr' elements
+            AllocCounters xc;
+            Adaptor crx{SimpleAllocator<char>(&xc)};
+            typedef std::basic_string<char, std::char_traits<char>,
+                                      PMR<char>> pmr_string;
+            typedef static_resource_allocator<pmr_string, Adaptor> StrAlloc;
+            {
+                std::vector<pmr_string, StrAlloc> v{StrAlloc(&crx)};
+                for (int i = 0; i < 10; ++i) {
+                    v.emplace_back("a string long enough to allocate memory");
+                }
+                ASSERT(10 == v.size());
+                ASSERT(&crx == v.back().get_allocator().resource());
+                ASSERT(xc.blocks_outstanding() > 10);
+            }
+            ASSERT(0 == xc.blocks_outstanding());
+        }
+      } if (test != 0) break;
+
+      case 3:
+      {
+        // --------------------------------------------------------------------
+        // BATCH ALLOCATION
+        // --------------------------------------------------------------------
+
+        std::cout << "\nBATCH ALLOCATION"
+                  << "\n================" << std::endl;
+
+        {
+            // Default 'allocate_n' and 'deallocate_n' loop over
+            // 'do_allocate' and 'do_deallocate'.
+            TestResource tr;
+            void *blocks[10];
+            tr.allocate_n(10, 24, 8, blocks);
+            ASSERT(10 == tr.counters().blocks_outstanding());
+            ASSERT(240 == tr.counters().bytes_outstanding());
+            tr.deallocate(blocks[9], 24, 8);
+            tr.deallocate_n(blocks, 9, 24, 8);
+            ASSERT(0 == tr.counters().blocks_outstanding());
+        }
+
+        {
+            // 'resource_adaptor' dispatches on the alignment once per batch.
+            AllocCounters xc;
+            SimpleAllocator<char> sax(&xc);
+            resource_adaptor<SimpleAllocator<char>> crx(sax);
+
+            void *blocks[5];
+            crx.allocate_n(5, 12, 4, blocks);
+            ASSERT(5 == xc.blocks_outstanding());
+            ASSERT(60 == xc.bytes_outstanding());
+            for (void *p : blocks) {
+                ASSERT(0 == reinterpret_cast<std::uintptr_t>(p) % 4);
+            }
+            crx.deallocate(blocks[0], 12, 4);
+            crx.deallocate_n(blocks + 1, 4, 12, 4);
+            ASSERT(0 == xc.blocks_outstanding());
+
+            bool caught = false;
+            try {
+                crx.allocate_n(2, 8, 2 * alignof(max_align_t), blocks);
+            }
+            catch (const std::bad_alloc&) {
+                caught = true;
+            }
+            ASSERT(caught);
+            ASSERT(0 == xc.blocks_outstanding());
+        }
+
+        {
+            // 'polymorphic_allocator' forwards to the resource in batches.
+            TestResource tr;
+            polymorphic_allocator<double> a(&tr);
+
+            double *ps[40];
+            a.allocate_n(40, ps);
+            ASSERT(40 == tr.counters().blocks_outstanding());
+            ASSERT(int(40 * sizeof(double)) ==
+                   tr.counters().bytes_outstanding());
+            a.deallocate(ps[0], 1);
+            a.deallocate_n(ps + 1, 39);
+            ASSERT(0 == tr.counters().blocks_outstanding());
+        }
+      } if (test != 0) break;
+
       case 2:
       {
           // Usage test
@@ -922,8 +1083,8 @@ int main(int argc, char *argv[])
 
             SimpleAllocator<char> sax(&xc);
             SimpleAllocator<char> say(&yc);
-            pmr::resource_adaptor<SimpleAllocator<char>> crx(sax);
-            pmr::resource_adaptor<SimpleAllocator<char>> cry(say);
+            resource_adaptor<SimpleAllocator<char>> crx(sax);
+            resource_adaptor<SimpleAllocator<char>> cry(say);
 
             strvec    a(&crx);
             strvecvec b(&cry);
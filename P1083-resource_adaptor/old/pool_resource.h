@@ -0,0 +1,261 @@
+/* pool_resource.h                  -*-C++-*-
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ *    (See accompanying file LICENSE_1_0.txt or copy at
+ *          http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef INCLUDED_POOL_RESOURCE_DOT_H
+#define INCLUDED_POOL_RESOURCE_DOT_H
+
+#include <polymorphic_allocator.h>
+
+BEGIN_NAMESPACE_XSTD
+
+namespace pmr {
+
+// Memory resource that serves small blocks from per-size free lists, carving
+// them out of chunks obtained from an upstream resource.  Blocks larger than
+// 'max_pooled_block' or more aligned than 'max_align_t' are passed through to
+// the upstream resource.  Deallocated blocks go back on their free list;
+// chunks are returned to the upstream resource only by 'release' or the
+// destructor.  The batch operations fill or drain a free list with a single
+// call and obtain at most one chunk per batch.  Not thread-safe.
+class pool_resource : public memory_resource
+{
+    // Block sizes are powers of two from 8 (large enough to hold a free-list
+    // link) to 'max_pooled_block'.
+    static const size_t min_block_log2 = 3;
+    static const size_t max_block_log2 = 8;
+    static const size_t num_pools = max_block_log2 - min_block_log2 + 1;
+
+    // Minimum number of blocks carved from each chunk
+    static const size_t blocks_per_chunk = 32;
+
+    struct free_block
+    {
+        free_block *m_next;
+    };
+
+    // Bookkeeping stored at the end of each chunk, after its blocks
+    struct chunk_footer
+    {
+        chunk_footer *m_next;
+        void         *m_begin;
+        size_t        m_bytes;
+    };
+
+    memory_resource *m_upstream;
+    free_block      *m_free[num_pools];
+    chunk_footer    *m_chunks;
+
+    // Return the index of the pool for blocks of the specified 'bytes' and
+    // 'alignment', or 'num_pools' if such blocks are not pooled.
+    static size_t pool_index(size_t bytes, size_t alignment);
+
+    // Allocate a chunk of at least 'min_blocks' blocks from upstream and
+    // push its blocks onto the free list for pool 'index'.
+    void replenish(size_t index, size_t min_blocks);
+
+  public:
+    static const size_t max_pooled_block = size_t(1) << max_block_log2;
+
+    explicit pool_resource(memory_resource *upstream = get_default_resource());
+
+    pool_resource(const pool_resource&) = delete;
+    pool_resource& operator=(const pool_resource&) = delete;
+
+    virtual ~pool_resource();
+
+    // Return all chunks to the upstream resource, even if blocks allocated
+    // from them have not been deallocated.
+    void release();
+
+    memory_resource *upstream_resource() const { return m_upstream; }
+
+  private:
+    virtual void *do_allocate(size_t bytes, size_t alignment);
+    virtual void do_deallocate(void *p, size_t bytes, size_t alignment);
+
+    virtual void do_allocate_n(size_t count, size_t bytes, size_t alignment,
+                               void *out[]);
+    virtual void do_deallocate_n(void *const blocks[], size_t count,
+                                 size_t bytes, size_t alignment);
+
+    virtual bool do_is_equal(const memory_resource& other) const;
+};
+
+} // end namespace pmr
+
+///////////////////////////////////////////////////////////////////////////////
+// INLINE AND TEMPLATE FUNCTION IMPLEMENTATIONS
+///////////////////////////////////////////////////////////////////////////////
+
+inline
+size_t pmr::pool_resource::pool_index(size_t bytes, size_t alignment)
+{
+    if (alignment > alignof(max_align_t) || bytes > max_pooled_block)
+        return num_pools;
+
+    // Blocks are at least as aligned as they are large, up to
+    // 'alignof(max_align_t)', so only the size determines the pool.
+    size_t index = 0;
+    while ((size_t(1) << (min_block_log2 + index)) < bytes)
+        ++index;
+    return index;
+}
+
+inline
+void pmr::pool_resource::replenish(size_t index, size_t min_blocks)
+{
+    const size_t block_size = size_t(1) << (min_block_log2 + index);
+    const size_t num_blocks =
+        min_blocks > blocks_per_chunk ? min_blocks : blocks_per_chunk;
+    const size_t bytes = num_blocks * block_size + sizeof(chunk_footer);
+
+    char *begin = static_cast<char*>(
+        m_upstream->allocate(bytes, alignof(max_align_t)));
+
+    chunk_footer *footer =
+        reinterpret_cast<chunk_footer*>(begin + num_blocks * block_size);
+    footer->m_next  = m_chunks;
+    footer->m_begin = begin;
+    footer->m_bytes = bytes;
+    m_chunks = footer;
+
+    // Push the blocks in reverse so that they are handed out in address
+    // order.
+    free_block *head = m_free[index];
+    for (size_t i = num_blocks; i > 0; --i) {
+        free_block *block =
+            reinterpret_cast<free_block*>(begin + (i - 1) * block_size);
+        block->m_next = head;
+        head = block;
+    }
+    m_free[index] = head;
+}
+
+inline
+pmr::pool_resource::pool_resource(memory_resource *upstream)
+    : m_upstream(upstream ? upstream : get_default_resource())
+    , m_chunks(nullptr)
+{
+    for (free_block *&head : m_free)
+        head = nullptr;
+}
+
+inline
+pmr::pool_resource::~pool_resource()
+{
+    release();
+}
+
+inline
+void pmr::pool_resource::release()
+{
+    while (m_chunks) {
+        chunk_footer *footer = m_chunks;
+        m_chunks = footer->m_next;
+        m_upstream->deallocate(footer->m_begin, footer->m_bytes,
+                               alignof(max_align_t));
+    }
+
+    for (free_block *&head : m_free)
+        head = nullptr;
+}
+
+inline
+void *pmr::pool_resource::do_allocate(size_t bytes, size_t alignment)
+{
+    const size_t index = pool_index(bytes, alignment);
+    if (num_pools == index)
+        return m_upstream->allocate(bytes, alignment);
+
+    if (! m_free[index])
+        replenish(index, 1);
+
+    free_block *block = m_free[index];
+    m_free[index] = block->m_next;
+    return block;
+}
+
+inline
+void pmr::pool_resource::do_deallocate(void *p, size_t bytes,
+                                       size_t alignment)
+{
+    const size_t index = pool_index(bytes, alignment);
+    if (num_pools == index) {
+        m_upstream->deallocate(p, bytes, alignment);
+        return;
+    }
+
+    free_block *block = static_cast<free_block*>(p);
+    block->m_next = m_free[index];
+    m_free[index] = block;
+}
+
+inline
+void pmr::pool_resource::do_allocate_n(size_t count, size_t bytes,
+                                       size_t alignment, void *out[])
+{
+    const size_t index = pool_index(bytes, alignment);
+    if (num_pools == index) {
+        m_upstream->allocate_n(count, bytes, alignment, out);
+        return;
+    }
+
+    // Take what the free list has, then replenish it once for the rest.
+    free_block *head = m_free[index];
+    size_t i = 0;
+    for (; i < count && head; ++i) {
+        out[i] = head;
+        head = head->m_next;
+    }
+    m_free[index] = head;
+
+    if (i < count) {
+        try {
+            replenish(index, count - i);
+        }
+        catch (...) {
+            do_deallocate_n(out, i, bytes, alignment);
+            throw;
+        }
+
+        head = m_free[index];
+        for (; i < count; ++i) {
+            out[i] = head;
+            head = head->m_next;
+        }
+        m_free[index] = head;
+    }
+}
+
+inline
+void pmr::pool_resource::do_deallocate_n(void *const blocks[], size_t count,
+                                         size_t bytes, size_t alignment)
+{
+    const size_t index = pool_index(bytes, alignment);
+    if (num_pools == index) {
+        m_upstream->deallocate_n(blocks, count, bytes, alignment);
+        return;
+    }
+
+    free_block *head = m_free[index];
+    for (size_t i = 0; i < count; ++i) {
+        free_block *block = static_cast<free_block*>(blocks[i]);
+        block->m_next = head;
+        head = block;
+    }
+    m_free[index] = head;
+}
+
+inline
+bool pmr::pool_resource::do_is_equal(const memory_resource& other) const
+{
+    return this == &other;
+}
+
+END_NAMESPACE_XSTD
+
+#endif // ! defined(INCLUDED_POOL_RESOURCE_DOT_H)
@@ -0,0 +1,176 @@
+/* pool_resource.t.cpp                  -*-C++-*-
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ *    (See accompanying file LICENSE_1_0.txt or copy at
+ *          http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include <pool_resource.h>
+
+#include <iostream>
+#include <cstdlib>
+#include <cstdint>
+#include <set>
+
+//==========================================================================
+//                  ASSERT TEST MACRO
+//--------------------------------------------------------------------------
+static int testStatus = 0;
+
+static void aSsErT(int c, const char *s, int i) {
+    if (c) {
+        std::cout << __FILE__ << ":" << i << ": error: " << s
+                  << "    (failed)" << std::endl;
+        if (testStatus >= 0 && testStatus <= 100) ++testStatus;
+    }
+}
+
+# define ASSERT(X) { aSsErT(!(X), #X, __LINE__); }
+
+//=============================================================================
+//                  CLASSES FOR TESTING
+//-----------------------------------------------------------------------------
+
+// Upstream resource that counts calls and outstanding blocks
+class TestResource : public XSTD::pmr::memory_resource
+{
+  public:
+    int m_allocate_calls   = 0;
+    int m_allocate_n_calls = 0;
+    int m_blocks           = 0;
+
+    virtual ~TestResource() { ASSERT(0 == m_blocks); }
+
+  private:
+    virtual void *do_allocate(std::size_t bytes, std::size_t alignment) {
+        ++m_allocate_calls;
+        ++m_blocks;
+        return std::malloc(bytes);
+    }
+
+    virtual void do_deallocate(void *p, std::size_t, std::size_t) {
+        --m_blocks;
+        std::free(p);
+    }
+
+    virtual void do_allocate_n(std::size_t count, std::size_t bytes,
+                               std::size_t alignment, void *out[]) {
+        ++m_allocate_n_calls;
+        for (std::size_t i = 0; i < count; ++i)
+            out[i] = std::malloc(bytes);
+        m_blocks += int(count);
+    }
+
+    virtual bool do_is_equal(const memory_resource& other) const {
+        return this == &other;
+    }
+};
+
+bool isAligned(void *p, std::size_t alignment)
+{
+    return 0 == reinterpret_cast<std::uintptr_t>(p) % alignment;
+}
+
+//=============================================================================
+//                              MAIN PROGRAM
+//-----------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    using XSTD::pmr::pool_resource;
+    using XSTD::pmr::polymorphic_allocator;
+
+    {
+        // Single allocations are served from chunks.
+
+        TestResource upstream;
+        pool_resource pool(&upstream);
+        ASSERT(pool.upstream_resource() == &upstream);
+
+        void *p1 = pool.allocate(20, 4);
+        ASSERT(1 == upstream.m_allocate_calls);
+        ASSERT(isAligned(p1, 4));
+        void *p2 = pool.allocate(32, 8);
+        ASSERT(1 == upstream.m_allocate_calls);  // Same pool
+        ASSERT(isAligned(p2, 8));
+        ASSERT(p1 != p2);
+
+        pool.deallocate(p2, 32, 8);
+        ASSERT(pool.allocate(17, 1) == p2);      // Reused
+
+        void *p3 = pool.allocate(1, 1);
+        ASSERT(2 == upstream.m_allocate_calls);  // New pool
+
+        // Too large: passed through to upstream
+        void *big = pool.allocate(pool_resource::max_pooled_block + 1, 8);
+        ASSERT(3 == upstream.m_allocate_calls);
+        ASSERT(3 == upstream.m_blocks);
+        pool.deallocate(big, pool_resource::max_pooled_block + 1, 8);
+        ASSERT(2 == upstream.m_blocks);
+
+        pool.deallocate(p1, 20, 4);
+        pool.deallocate(p2, 17, 1);
+        pool.deallocate(p3, 1, 1);
+        ASSERT(2 == upstream.m_blocks);          // Chunks are retained
+
+        pool.release();
+        ASSERT(0 == upstream.m_blocks);
+    }
+
+    {
+        // A batch is served by at most one new chunk.
+
+        TestResource upstream;
+        pool_resource pool(&upstream);
+
+        void *blocks[100];
+        pool.allocate_n(100, 64, 8, blocks);
+        ASSERT(1 == upstream.m_allocate_calls);
+
+        std::set<void*> distinct(blocks, blocks + 100);
+        ASSERT(100 == distinct.size());
+        for (void *p : blocks) {
+            ASSERT(isAligned(p, 8));
+        }
+
+        // Blocks from a batch can be deallocated individually, and blocks
+        // allocated individually can be deallocated in a batch.
+        pool.deallocate(blocks[0], 64, 8);
+        pool.deallocate_n(blocks + 1, 99, 64, 8);
+        void *more[150];
+        pool.allocate_n(150, 64, 8, more);
+        ASSERT(2 == upstream.m_allocate_calls);
+        pool.deallocate_n(more, 150, 64, 8);
+
+        // Batches of unpooled blocks are forwarded as a batch.
+        pool.allocate_n(10, 1000, 8, blocks);
+        ASSERT(1 == upstream.m_allocate_n_calls);
+        ASSERT(12 == upstream.m_blocks);
+        pool.deallocate_n(blocks, 10, 1000, 8);
+        ASSERT(2 == upstream.m_blocks);
+    }
+
+    {
+        // Use with 'polymorphic_allocator'
+
+        TestResource upstream;
+        {
+            pool_resource pool(&upstream);
+            polymorphic_allocator<long> a(&pool);
+
+            long *ps[32];
+            a.allocate_n(32, ps);
+            for (int i = 0; i < 32; ++i) {
+                *ps[i] = i;
+            }
+            for (int i = 0; i < 32; ++i) {
+                ASSERT(i == *ps[i]);
+            }
+            ASSERT(1 == upstream.m_allocate_calls);
+            a.deallocate_n(ps, 32);
+        }
+        ASSERT(0 == upstream.m_blocks);  // Released by the destructor
+    }
+
+    return testStatus;
+}
@@ -7,9 +7,13 @@
  */
 
 #include <resource_adaptor.h>
+#include <resource_adaptor_allocator.h>
 
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <deque>
+#include <vector>
 
 //==========================================================================
 //                  ASSERT TEST MACRO
@@ -83,6 +87,71 @@ bool operator!=(const DummyAllocator<Tp1>& a, const DummyAllocator<Tp2>& b)
     return ! (a == b);
 }
 
+// Allocator that allocates real memory from `std::allocator` and records the
+// size and alignment of the last request in a `Block`.
+template <typename Tp>
+class RecordingAllocator
+{
+    Block *d_last_p;
+
+  public:
+    typedef Tp value_type;
+
+    RecordingAllocator(Block* last_p) : d_last_p(last_p) { }
+
+    // Required constructor
+    template <typename T>
+    RecordingAllocator(const RecordingAllocator<T>& other)
+        : d_last_p(other.last()) { }
+
+    Tp* allocate(std::size_t n) {
+        *d_last_p = Block(sizeof(Tp) * n, alignof(Tp));
+        return std::allocator<Tp>().allocate(n);
+    }
+
+    void deallocate(Tp* p, std::size_t n) {
+        *d_last_p = Block(sizeof(Tp) * n, alignof(Tp));
+        std::allocator<Tp>().deallocate(p, n);
+    }
+
+    Block *last() const { return d_last_p; }
+};
+
+template <typename Tp1, typename Tp2>
+bool operator==(const RecordingAllocator<Tp1>& a,
+                const RecordingAllocator<Tp2>& b)
+{
+    return a.last() == b.last();
+}
+
+template <typename Tp1, typename Tp2>
+bool operator!=(const RecordingAllocator<Tp1>& a,
+                const RecordingAllocator<Tp2>& b)
+{
+    return ! (a == b);
+}
+
+// Allocate and deallocate blocks of several sizes aligned to each power of 2
+// from just over `MaxAlign` to 4096 through `crx`, checking that each block
+// is aligned and writable and that `crx` over-allocates from its allocator
+// rebound for `MaxAlign`.
+template <std::size_t MaxAlign, class Resource>
+void testOveraligned(Resource& crx, Block& last)
+{
+    for (std::size_t a = 2 * MaxAlign; a <= 4096; a *= 2) {
+        for (std::size_t bytes : { std::size_t(1), a - 1, a, 3 * a + 5 }) {
+            void *p = crx.allocate(bytes, a);
+            TEST_ASSERT(0 == reinterpret_cast<std::uintptr_t>(p) % a);
+            TEST_ASSERT(last.d_align == MaxAlign);
+            TEST_ASSERT(last.d_size >= bytes + a - MaxAlign);
+            std::memset(p, 0xA5, bytes);
+
+            crx.deallocate(p, bytes, a);
+            TEST_ASSERT(last.d_align == MaxAlign);
+        }
+    }
+}
+
 //=============================================================================
 //                              MAIN TEST FUNCTION
 //-----------------------------------------------------------------------------
@@ -124,14 +193,10 @@ inline int test()
             crx.deallocate(b3, 3 * a, a);
         }
 
-        // `a` is now double `MaxAlign`
-        try {
-            [[maybe_unused]] void* p = crx.allocate(1, a);
-            TEST_ASSERT(false && "Allocation should have failed");
-        }
-        catch (const std::bad_alloc&)
-        {
-        }
+        // Alignments above `MaxAlignment` are satisfied by over-allocating.
+        Block last(0, 0);
+        XPMR::resource_adaptor<RecordingAllocator<char>> real(&last);
+        testOveraligned<XSTD::max_align_v>(real, last);
     }
 
     {
@@ -159,14 +224,116 @@ inline int test()
             crx.deallocate(b3, 3 * a, a);
         }
 
-        // `a` is now double `MaxAlign`
-        try {
-            [[maybe_unused]] void* p = crx.allocate(1, a);
-            TEST_ASSERT(false && "Allocation should have failed");
-        }
-        catch (const std::bad_alloc&)
-        {
+        // Alignments above `MaxAlignment` are satisfied by over-allocating.
+        Block last(0, 0);
+        XPMR::resource_adaptor<RecordingAllocator<char>,
+                               4 * XSTD::max_align_v> real(&last);
+        testOveraligned<4 * XSTD::max_align_v>(real, last);
+    }
+
+    {
+        // Test with a `MaxAlignment` smaller than the offset header
+
+        Block last(0, 0);
+        XPMR::resource_adaptor<RecordingAllocator<char>, 2> real(&last);
+        testOveraligned<2>(real, last);
+
+        void *p = real.allocate(10, 1);
+        TEST_ASSERT(last.d_align == 1);
+        real.deallocate(p, 10, 1);
+    }
+
+    {
+        // Test the compile-time alignment entry points
+
+        std::deque<Block> blocks;
+
+        XPMR::resource_adaptor<DummyAllocator<char>> crx(&blocks);
+
+        Block* b1 = static_cast<Block*>(crx.allocate_aligned<8>(20));
+        TEST_ASSERT(b1->d_size == 24);  // 20 rounded up to alignment
+        TEST_ASSERT(b1->d_align == 8);
+        crx.deallocate(b1, 20, 8);      // Interchangeable with `deallocate`
+        TEST_ASSERT(b1->d_size == 0);
+
+        Block* b2 = static_cast<Block*>(crx.allocate(3, 1));
+        crx.deallocate_aligned<1>(b2, 3);
+        TEST_ASSERT(b2->d_size == 0);
+
+        constexpr std::size_t maxA = XSTD::max_align_v;
+        Block* b3 = static_cast<Block*>(crx.allocate_aligned<maxA>(1));
+        TEST_ASSERT(b3->d_size == maxA);
+        TEST_ASSERT(b3->d_align == maxA);
+        crx.deallocate_aligned<maxA>(b3, 1);
+
+    }
+
+    {
+        // Compile-time alignments above `MaxAlignment`
+
+        constexpr std::size_t maxA = XSTD::max_align_v;
+
+        Block last(0, 0);
+        XPMR::resource_adaptor<RecordingAllocator<char>> crx(&last);
+
+        void *p = crx.allocate_aligned<4096>(100);
+        TEST_ASSERT(0 == reinterpret_cast<std::uintptr_t>(p) % 4096);
+        TEST_ASSERT(last.d_align == maxA);
+        crx.deallocate(p, 100, 4096);   // Interchangeable with `deallocate`
+        TEST_ASSERT(last.d_align == maxA);
+
+        p = crx.allocate(64, 4 * maxA);
+        crx.deallocate_aligned<4 * maxA>(p, 64);
+
+        // Typed allocator for an over-aligned type
+        struct alignas(64) CacheLine { char d_bytes[64]; };
+        using Rsrc = XPMR::resource_adaptor<RecordingAllocator<char>>;
+        XPMR::resource_adaptor_allocator<CacheLine, Rsrc> a(&crx);
+        CacheLine *cl = a.allocate(3);
+        TEST_ASSERT(0 == reinterpret_cast<std::uintptr_t>(cl) % 64);
+        a.deallocate(cl, 3);
+    }
+
+    {
+        // Test the typed allocator front end
+
+        using Rsrc = XPMR::resource_adaptor<DummyAllocator<char>>;
+
+        std::deque<Block> blocks;
+        Rsrc              crx(&blocks);
+
+        XPMR::resource_adaptor_allocator<double, Rsrc> a(&crx);
+        TEST_ASSERT(a.resource() == &crx);
+
+        double* d = a.allocate(5);
+        Block*  b = reinterpret_cast<Block*>(d);
+        TEST_ASSERT(b->d_size == 5 * sizeof(double));
+        TEST_ASSERT(b->d_align == alignof(double));
+        a.deallocate(d, 5);
+        TEST_ASSERT(b->d_size == 0);
+
+        // Rebinding conversion and equality
+        XPMR::resource_adaptor_allocator<short, Rsrc> a2(a);
+        TEST_ASSERT(a2.resource() == &crx);
+        TEST_ASSERT(a2 == a);
+
+        Rsrc crx2(&blocks);  // Different resource, equal allocator
+        TEST_ASSERT(a == (XPMR::resource_adaptor_allocator<char, Rsrc>(&crx2)));
+
+        std::deque<Block> blocks3;
+        Rsrc              crx3(&blocks3);
+        TEST_ASSERT(a != (XPMR::resource_adaptor_allocator<char, Rsrc>(&crx3)));
+
+        // Use in a standard container with real memory
+        using RealRsrc = XPMR::resource_adaptor<std::allocator<char>>;
+        using RealAlloc = XPMR::resource_adaptor_allocator<int, RealRsrc>;
+        RealRsrc                    real;
+        std::vector<int, RealAlloc> v{ RealAlloc(&real) };
+        for (int i = 0; i < 100; ++i) {
+            v.push_back(i);
         }
+        TEST_ASSERT(100 == v.size());
+        TEST_ASSERT(99 == v.back());
     }
 
     return testStatus;
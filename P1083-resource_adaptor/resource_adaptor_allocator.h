@@ -0,0 +1,90 @@
+/* resource_adaptor_allocator.h                  -*-C++-*-
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ *    (See accompanying file LICENSE_1_0.txt or copy at
+ *          http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+/* This component defines `resource_adaptor_allocator<T, Resource>`, a typed
+ * allocator front end for a `resource_adaptor` whose concrete type is known
+ * at compile time.  Because `alignof(T)` is also known at compile time, each
+ * allocation goes straight to the allocator rebound for the right
+ * `aligned_type` through the non-virtual `allocate_aligned` member of the
+ * resource, without the virtual call and the runtime alignment dispatch of
+ * `memory_resource::allocate`.  Memory allocated through it can be
+ * deallocated through `resource->deallocate(p, n * sizeof(T), alignof(T))`
+ * and vice versa, so it can share a resource with `polymorphic_allocator`.
+ */
+
+#ifndef INCLUDED_RESOURCE_ADAPTOR_ALLOCATOR_DOT_H
+#define INCLUDED_RESOURCE_ADAPTOR_ALLOCATOR_DOT_H
+
+#include <xstd.h>
+#include <cstddef>
+#include <limits>
+#include <new>
+
+BEGIN_NAMESPACE_XPMR
+
+template <class Tp, class Resource>
+class resource_adaptor_allocator
+{
+    Resource *m_resource_p;
+
+  public:
+    typedef Tp       value_type;
+    typedef Resource resource_type;
+
+    explicit resource_adaptor_allocator(Resource *r) noexcept
+        : m_resource_p(r) { }
+
+    template <class T>
+    resource_adaptor_allocator(
+        const resource_adaptor_allocator<T, Resource>& other) noexcept
+        : m_resource_p(other.resource()) { }
+
+    Tp *allocate(size_t n);
+    void deallocate(Tp *p, size_t n);
+
+    Resource *resource() const noexcept { return m_resource_p; }
+};
+
+template <class Tp1, class Tp2, class Resource>
+bool operator==(const resource_adaptor_allocator<Tp1, Resource>& a,
+                const resource_adaptor_allocator<Tp2, Resource>& b) noexcept
+{
+    return (a.resource() == b.resource() ||
+            a.resource()->is_equal(*b.resource()));
+}
+
+template <class Tp1, class Tp2, class Resource>
+bool operator!=(const resource_adaptor_allocator<Tp1, Resource>& a,
+                const resource_adaptor_allocator<Tp2, Resource>& b) noexcept
+{
+    return ! (a == b);
+}
+
+END_NAMESPACE_XPMR
+
+///////////////////////////////////////////////////////////////////////////////
+// INLINE AND TEMPLATE FUNCTION IMPLEMENTATIONS
+///////////////////////////////////////////////////////////////////////////////
+
+template <class Tp, class Resource>
+inline Tp *XPMR::resource_adaptor_allocator<Tp, Resource>::allocate(size_t n)
+{
+    if (n > numeric_limits<size_t>::max() / sizeof(Tp))
+        throw bad_array_new_length{};
+
+    return static_cast<Tp *>(
+        m_resource_p->template allocate_aligned<alignof(Tp)>(n * sizeof(Tp)));
+}
+
+template <class Tp, class Resource>
+inline void XPMR::resource_adaptor_allocator<Tp, Resource>::
+deallocate(Tp *p, size_t n)
+{
+    m_resource_p->template deallocate_aligned<alignof(Tp)>(p, n * sizeof(Tp));
+}
+
+#endif // ! defined(INCLUDED_RESOURCE_ADAPTOR_ALLOCATOR_DOT_H)
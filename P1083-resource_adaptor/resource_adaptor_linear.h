@@ -16,7 +16,10 @@
 #include <xstd.h>
 #include <memory>
 #include <cstddef> // max_align_t
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <limits>
 #include <cassert>
 #include <utility>
 #include <memory_resource>
@@ -50,10 +53,30 @@ class resource_adaptor_imp : public memory_resource
 
     allocator_type get_allocator() const noexcept { return m_alloc; }
 
+    // Allocate `bytes` bytes aligned to the compile-time `Align`, going
+    // directly to the allocator rebound for `aligned_type<Align>` without a
+    // virtual call or a runtime alignment dispatch.  The block may be
+    // deallocated with `deallocate_aligned<Align>(p, bytes)` or with
+    // `deallocate(p, bytes, Align)`, and vice versa.  An `Align` greater than
+    // `MaxAlignment` is supported by over-allocating, as for `allocate`.
+    template <size_t Align>
+    void *allocate_aligned(size_t bytes);
+
+    template <size_t Align>
+    void deallocate_aligned(void *p, size_t bytes);
+
   private:
     template <size_t Align, typename F>
     void linear_search_alignments(size_t alignment, F&& f);
 
+    // Allocate `bytes` bytes aligned to `alignment`, a power of 2 greater
+    // than `MaxAlignment`, by over-allocating a block aligned to
+    // `MaxAlignment` and storing the offset of the returned address from the
+    // start of that block in the bytes just before the returned address.
+    static constexpr size_t overaligned_padding(size_t alignment);
+    void *overaligned_allocate(size_t bytes, size_t alignment);
+    void overaligned_deallocate(void *p, size_t bytes, size_t alignment);
+
     void *do_allocate(size_t bytes, size_t alignment) override;
     void do_deallocate(void *p, size_t bytes, size_t alignment) override;
     bool do_is_equal(const memory_resource& other) const noexcept override;
@@ -98,6 +121,47 @@ XPMR::resource_adaptor_imp<Allocator, MaxAlignment>::resource_adaptor_imp(
 {
 }
 
+template <class Allocator, size_t MaxAlignment>
+template <size_t Align>
+inline void *XPMR::resource_adaptor_imp<Allocator, MaxAlignment>::
+allocate_aligned(size_t bytes)
+{
+    static_assert(0 != Align && 0 == (Align & (Align - 1)),
+                  "Align must be a power of 2");
+
+    if constexpr (Align > MaxAlignment)
+        return overaligned_allocate(bytes, Align);
+    else {
+        using chunk_alloc_t = typename allocator_traits<Allocator>::
+            template rebind_alloc<aligned_type<Align>>;
+
+        chunk_alloc_t chunk_alloc(m_alloc);
+        return allocator_traits<chunk_alloc_t>::allocate(
+            chunk_alloc, (bytes + Align - 1) / Align);
+    }
+}
+
+template <class Allocator, size_t MaxAlignment>
+template <size_t Align>
+inline void XPMR::resource_adaptor_imp<Allocator, MaxAlignment>::
+deallocate_aligned(void *p, size_t bytes)
+{
+    static_assert(0 != Align && 0 == (Align & (Align - 1)),
+                  "Align must be a power of 2");
+
+    if constexpr (Align > MaxAlignment)
+        return overaligned_deallocate(p, bytes, Align);
+    else {
+        using chunk_alloc_t = typename allocator_traits<Allocator>::
+            template rebind_alloc<aligned_type<Align>>;
+
+        chunk_alloc_t chunk_alloc(m_alloc);
+        auto chunk_p = static_cast<aligned_type<Align> *>(p);
+        allocator_traits<chunk_alloc_t>::deallocate(
+            chunk_alloc, chunk_p, (bytes + Align - 1) / Align);
+    }
+}
+
 // Perform a binary search for `alignment` among supported alignments.
 template <class Allocator, size_t MaxAlignment>
 template <size_t Align, typename F>
@@ -118,6 +182,49 @@ linear_search_alignments(size_t alignment, F&& f)
         linear_search_alignments<Align * 2>(alignment, f);
 }
 
+template <class Allocator, size_t MaxAlignment>
+constexpr size_t XPMR::resource_adaptor_imp<Allocator, MaxAlignment>::
+overaligned_padding(size_t alignment)
+{
+    // The start of the block is aligned to `MaxAlignment`, so the offset of
+    // the returned address is a multiple of `MaxAlignment` that leaves room
+    // for the offset header and is less than `alignment` past it.
+    constexpr size_t header =
+        (sizeof(size_t) + MaxAlignment - 1) & ~(MaxAlignment - 1);
+    return alignment - MaxAlignment + header;
+}
+
+template <class Allocator, size_t MaxAlignment>
+void *XPMR::resource_adaptor_imp<Allocator, MaxAlignment>::
+overaligned_allocate(size_t bytes, size_t alignment)
+{
+    const size_t padding = overaligned_padding(alignment);
+    if (bytes > numeric_limits<size_t>::max() - padding)
+        throw bad_alloc{};
+
+    char *block = static_cast<char *>(
+        allocate_aligned<MaxAlignment>(bytes + padding));
+
+    uintptr_t addr = reinterpret_cast<uintptr_t>(block) + sizeof(size_t);
+    addr = (addr + alignment - 1) & ~uintptr_t(alignment - 1);
+    char *ret = reinterpret_cast<char *>(addr);
+
+    const size_t offset = ret - block;
+    memcpy(ret - sizeof(size_t), &offset, sizeof(size_t));
+    return ret;
+}
+
+template <class Allocator, size_t MaxAlignment>
+void XPMR::resource_adaptor_imp<Allocator, MaxAlignment>::
+overaligned_deallocate(void *p, size_t bytes, size_t alignment)
+{
+    char  *ret = static_cast<char *>(p);
+    size_t offset;
+    memcpy(&offset, ret - sizeof(size_t), sizeof(size_t));
+    deallocate_aligned<MaxAlignment>(ret - offset,
+                                     bytes + overaligned_padding(alignment));
+}
+
 template <class Allocator, size_t MaxAlignment>
 void* XPMR::resource_adaptor_imp<Allocator, MaxAlignment>::
 do_allocate(size_t bytes, size_t alignment)
@@ -129,6 +236,9 @@ do_allocate(size_t bytes, size_t alignment)
             alignment = MaxAlignment;
     }
 
+    if (alignment > MaxAlignment)
+        return overaligned_allocate(bytes, alignment);
+
     size_t chunks = (bytes + alignment - 1) / alignment;
 
     void* ret = nullptr;
@@ -152,6 +262,9 @@ do_deallocate(void *p, size_t  bytes, size_t  alignment)
             alignment = MaxAlignment;
     }
 
+    if (alignment > MaxAlignment)
+        return overaligned_deallocate(p, bytes, alignment);
+
     // Assert that `alignment` is a power of 2
     assert(0 == (alignment & (alignment - 1)));
 
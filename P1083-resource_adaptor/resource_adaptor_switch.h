@@ -16,7 +16,10 @@
 #include <xstd.h>
 #include <memory>
 #include <cstddef> // max_align_t
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <limits>
 #include <utility>
 #include <cassert>
 #include <memory_resource>
@@ -48,6 +51,18 @@ class resource_adaptor_imp : public memory_resource
 
     allocator_type get_allocator() const noexcept { return m_alloc; }
 
+    // Allocate `bytes` bytes aligned to the compile-time `Align`, going
+    // directly to the allocator rebound for `aligned_type<Align>` without a
+    // virtual call or a runtime alignment dispatch.  The block may be
+    // deallocated with `deallocate_aligned<Align>(p, bytes)` or with
+    // `deallocate(p, bytes, Align)`, and vice versa.  An `Align` greater than
+    // `MaxAlignment` is supported by over-allocating, as for `allocate`.
+    template <size_t Align>
+    void *allocate_aligned(size_t bytes);
+
+    template <size_t Align>
+    void deallocate_aligned(void *p, size_t bytes);
+
   private:
     // Compute the log2(n), rounded down, for n <= MaxAlignment.  Uses at most
     // log2(log2(MaxAlignment)+1) right-shift operations (though each
@@ -80,6 +95,14 @@ class resource_adaptor_imp : public memory_resource
     template <size_t Align>
     void aligned_deallocate(void *p, size_t chunks);
 
+    // Allocate `bytes` bytes aligned to `alignment`, a power of 2 greater
+    // than `MaxAlignment`, by over-allocating a block aligned to
+    // `MaxAlignment` and storing the offset of the returned address from the
+    // start of that block in the bytes just before the returned address.
+    static constexpr size_t overaligned_padding(size_t alignment);
+    void *overaligned_allocate(size_t bytes, size_t alignment);
+    void overaligned_deallocate(void *p, size_t bytes, size_t alignment);
+
     void *do_allocate(size_t bytes, size_t alignment) override;
     void do_deallocate(void *p, size_t bytes, size_t alignment) override;
     bool do_is_equal(const memory_resource& other) const noexcept override;
@@ -109,6 +132,36 @@ XPMR::resource_adaptor_imp<Allocator, MaxAlignment>::resource_adaptor_imp(
 {
 }
 
+template <class Allocator, size_t MaxAlignment>
+template <size_t Align>
+inline void *XPMR::resource_adaptor_imp<Allocator, MaxAlignment>::
+allocate_aligned(size_t bytes)
+{
+    static_assert(0 != Align && 0 == (Align & (Align - 1)),
+                  "Align must be a power of 2");
+
+    if constexpr (Align > MaxAlignment)
+        return overaligned_allocate(bytes, Align);
+    else {
+        return aligned_allocate<Align>((bytes + Align - 1) / Align);
+    }
+}
+
+template <class Allocator, size_t MaxAlignment>
+template <size_t Align>
+inline void XPMR::resource_adaptor_imp<Allocator, MaxAlignment>::
+deallocate_aligned(void *p, size_t bytes)
+{
+    static_assert(0 != Align && 0 == (Align & (Align - 1)),
+                  "Align must be a power of 2");
+
+    if constexpr (Align > MaxAlignment)
+        return overaligned_deallocate(p, bytes, Align);
+    else {
+        aligned_deallocate<Align>(p, (bytes + Align - 1) / Align);
+    }
+}
+
 template <class Allocator, size_t MaxAlignment>
 template <size_t Align>
 void* XPMR::resource_adaptor_imp<Allocator, MaxAlignment>::
@@ -134,6 +187,49 @@ aligned_deallocate(void *p, size_t chunks)
     allocator_traits<chunk_alloc_t>::deallocate(chunk_alloc, chunk_p, chunks);
 }
 
+template <class Allocator, size_t MaxAlignment>
+constexpr size_t XPMR::resource_adaptor_imp<Allocator, MaxAlignment>::
+overaligned_padding(size_t alignment)
+{
+    // The start of the block is aligned to `MaxAlignment`, so the offset of
+    // the returned address is a multiple of `MaxAlignment` that leaves room
+    // for the offset header and is less than `alignment` past it.
+    constexpr size_t header =
+        (sizeof(size_t) + MaxAlignment - 1) & ~(MaxAlignment - 1);
+    return alignment - MaxAlignment + header;
+}
+
+template <class Allocator, size_t MaxAlignment>
+void *XPMR::resource_adaptor_imp<Allocator, MaxAlignment>::
+overaligned_allocate(size_t bytes, size_t alignment)
+{
+    const size_t padding = overaligned_padding(alignment);
+    if (bytes > numeric_limits<size_t>::max() - padding)
+        throw bad_alloc{};
+
+    char *block = static_cast<char *>(
+        allocate_aligned<MaxAlignment>(bytes + padding));
+
+    uintptr_t addr = reinterpret_cast<uintptr_t>(block) + sizeof(size_t);
+    addr = (addr + alignment - 1) & ~uintptr_t(alignment - 1);
+    char *ret = reinterpret_cast<char *>(addr);
+
+    const size_t offset = ret - block;
+    memcpy(ret - sizeof(size_t), &offset, sizeof(size_t));
+    return ret;
+}
+
+template <class Allocator, size_t MaxAlignment>
+void XPMR::resource_adaptor_imp<Allocator, MaxAlignment>::
+overaligned_deallocate(void *p, size_t bytes, size_t alignment)
+{
+    char  *ret = static_cast<char *>(p);
+    size_t offset;
+    memcpy(&offset, ret - sizeof(size_t), sizeof(size_t));
+    deallocate_aligned<MaxAlignment>(ret - offset,
+                                     bytes + overaligned_padding(alignment));
+}
+
 template <class Allocator, size_t MaxAlignment>
 void *XPMR::resource_adaptor_imp<Allocator, MaxAlignment>::
 do_allocate(size_t bytes, size_t alignment)
@@ -148,6 +244,9 @@ do_allocate(size_t bytes, size_t alignment)
         // Assert that `alignment` is a power of 2
         assert(0 == (alignment & (alignment - 1)));
 
+    if (alignment > MaxAlignment)
+        return overaligned_allocate(bytes, alignment);
+
     size_t chunks = (bytes + alignment - 1) / alignment;
 
 #define ALLOC_CASE(n) \
@@ -241,6 +340,9 @@ do_deallocate(void *p, size_t  bytes, size_t  alignment)
         // Assert that `alignment` is a power of 2
         assert(0 == (alignment & (alignment - 1)));
 
+    if (alignment > MaxAlignment)
+        return overaligned_deallocate(p, bytes, alignment);
+
     size_t chunks = (bytes + alignment - 1) / alignment;
 
 #define DEALLOC_CASE(n) \
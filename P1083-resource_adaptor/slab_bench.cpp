@@ -0,0 +1,157 @@
+// slab_bench.cpp                                                     -*-C++-*-
+
+// Compare the throughput of `slab_resource` with that of
+// `std::pmr::synchronized_pool_resource` (and of `new_delete_resource`, for
+// reference) when several threads allocate and deallocate small blocks, as a
+// node-based container does.
+//
+// Usage: slab_bench [ threads [ blocks [ rounds [ repeats ] ] ] ]
+//
+// Each of `threads` (default 4) threads allocates `blocks` (default 1024)
+// blocks of sizes cycling through 16, 32, 48, and 64 bytes, and then
+// deallocates blocks, `rounds` (default 200) times.  In the `local` pattern,
+// each thread deallocates its own blocks; in the `handoff` pattern, each
+// thread deallocates the blocks allocated by the next thread, after all
+// threads have finished allocating, so that every block is freed by a thread
+// other than the one that allocated it.  This is repeated `repeats` (default
+// 3) times and the fastest repetition is reported.  Each line of output has
+// the pattern, the number of threads, the resource, and the mean time in ns
+// for one allocation plus its deallocation, measured as the wall-clock time
+// from the first thread starting to the last thread finishing, divided by the
+// number of blocks allocated by each thread.
+
+#include "slab_resource.h"
+
+#include <algorithm>
+#include <barrier>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::size_t blockSize(std::size_t i)
+{
+    return 16 * (1 + i % 4);
+}
+
+double nsPerAllocation(std::pmr::memory_resource *rsrc,
+                       bool                       handoff,
+                       std::size_t                numThreads,
+                       std::size_t                blocks,
+                       std::size_t                rounds)
+    // Return the mean wall-clock time in ns for each thread to allocate and
+    // deallocate a block from `rsrc`.
+{
+    std::vector<std::vector<void*>> ptrs(numThreads,
+                                         std::vector<void*>(blocks));
+    std::barrier sync(std::ptrdiff_t(numThreads + 1));
+
+    // Each thread times itself, because a thread may start, or even finish,
+    // before the main thread is scheduled again after a barrier.
+    using clock = std::chrono::steady_clock;
+    std::vector<clock::time_point> starts(numThreads), ends(numThreads);
+
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&, t] {
+            const std::size_t victim = handoff ? (t + 1) % numThreads : t;
+            sync.arrive_and_wait();
+            starts[t] = clock::now();
+            for (std::size_t round = 0; round < rounds; ++round) {
+                for (std::size_t i = 0; i < blocks; ++i) {
+                    ptrs[t][i] = rsrc->allocate(blockSize(i), 8);
+                }
+                if (handoff) sync.arrive_and_wait();
+                for (std::size_t i = 0; i < blocks; ++i) {
+                    rsrc->deallocate(ptrs[victim][i], blockSize(i), 8);
+                }
+                if (handoff) sync.arrive_and_wait();
+            }
+            ends[t] = clock::now();
+        });
+    }
+
+    // The main thread takes part in the barriers so that the workers start
+    // together.
+    sync.arrive_and_wait();
+    if (handoff) {
+        for (std::size_t i = 0; i < 2 * rounds; ++i) {
+            sync.arrive_and_wait();
+        }
+    }
+    else {
+        sync.arrive_and_drop();
+    }
+    for (std::thread& th : threads) {
+        th.join();
+    }
+    std::chrono::duration<double, std::nano> elapsed =
+        *std::max_element(ends.begin(), ends.end()) -
+        *std::min_element(starts.begin(), starts.end());
+
+    return elapsed.count() / double(blocks * rounds);
+}
+
+std::size_t parseArg(int argc, char *argv[], int i, std::size_t dflt)
+{
+    if (i >= argc) return dflt;
+    char *end;
+    unsigned long long value = std::strtoull(argv[i], &end, 10);
+    if (*end || 0 == value) {
+        std::cerr << "Usage: slab_bench [ threads [ blocks [ rounds "
+                     "[ repeats ] ] ] ]" << std::endl;
+        std::exit(2);
+    }
+    return std::size_t(value);
+}
+
+} // close unnamed namespace
+
+int main(int argc, char *argv[])
+{
+    const std::size_t numThreads = parseArg(argc, argv, 1, 4);
+    const std::size_t blocks     = parseArg(argc, argv, 2, 1024);
+    const std::size_t rounds     = parseArg(argc, argv, 3, 200);
+    const std::size_t repeats    = parseArg(argc, argv, 4, 3);
+
+    std::cout << "pattern,threads,resource,ns" << std::endl;
+
+    for (bool handoff : { false, true }) {
+        const char *pattern = handoff ? "handoff" : "local";
+
+        // A fresh resource for each repetition, so that each starts without
+        // cached memory; the fastest repetition is reported.
+        auto run = [&](const char *name, auto make) {
+            double best = 1e300;
+            for (std::size_t rep = 0; rep < repeats; ++rep) {
+                auto rsrc = make();
+                best = std::min(best, nsPerAllocation(rsrc.get(), handoff,
+                                                      numThreads, blocks,
+                                                      rounds));
+            }
+            std::cout << pattern << ',' << numThreads << ',' << name << ','
+                      << std::fixed << std::setprecision(2) << best
+                      << std::endl;
+        };
+
+        run("slab_resource", [] {
+            return std::shared_ptr<std::pmr::memory_resource>(
+                std::make_unique<XPMR::slab_resource>());
+        });
+        run("synchronized_pool_resource", [] {
+            return std::shared_ptr<std::pmr::memory_resource>(
+                std::make_unique<std::pmr::synchronized_pool_resource>());
+        });
+        run("new_delete_resource", [] {
+            // Not owned
+            return std::shared_ptr<std::pmr::memory_resource>(
+                std::pmr::new_delete_resource(), [](auto *) { });
+        });
+    }
+}
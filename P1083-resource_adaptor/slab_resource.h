@@ -0,0 +1,308 @@
+/* slab_resource.h                  -*-C++-*-
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ *    (See accompanying file LICENSE_1_0.txt or copy at
+ *          http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+/* This component defines `slab_resource`, a thread-safe `memory_resource`
+ * for the small, fixed-size blocks of node-based containers.  A request is
+ * rounded up to a power-of-two size class and served from a free list of
+ * blocks of that class, carved out of large slabs obtained from an upstream
+ * resource.  The free lists are lock-free (Treiber) stacks whose head is a
+ * tagged pointer: the top 16 bits of the 64-bit head word hold a counter
+ * that is incremented by every update, so a pop that read a stale head
+ * cannot succeed after the same block has been popped and pushed back (the
+ * ABA problem).  To spread contention, each size class has several free
+ * lists ("stripes"); threads are assigned to stripes round robin, push to
+ * their own stripe, and pop from it first, then from the others.
+ *
+ * Any thread may deallocate a block allocated by any other thread.  Blocks
+ * are never returned to the upstream resource before the slab resource is
+ * destroyed, which is what makes it safe for a pop to read the link of a
+ * block that another thread has just popped.  The upstream resource is
+ * called only under a lock, for new slabs and for requests larger than
+ * `max_block_size`, so it need not be thread-safe.
+ *
+ * The packing of the tag requires that user-space addresses fit in 48 bits,
+ * which is the case on x86-64 and AArch64 unless 57-bit addresses are
+ * explicitly requested from the operating system.
+ */
+
+#ifndef INCLUDED_SLAB_RESOURCE_DOT_H
+#define INCLUDED_SLAB_RESOURCE_DOT_H
+
+#include <xstd.h>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <vector>
+
+BEGIN_NAMESPACE_XPMR
+
+// Tuning of a `slab_resource`.
+struct slab_options
+{
+    // Largest request (rounded up to a power of 2) that is served from
+    // slabs.  Larger requests go to the upstream resource.
+    size_t max_block_size = 512;
+
+    // Size of each slab obtained from the upstream resource.  A slab holds
+    // blocks of one size class only.
+    size_t slab_size = 64 * 1024;
+
+    // Number of free lists for each size class.
+    size_t stripes = 4;
+};
+
+class slab_resource : public memory_resource
+{
+  public:
+    explicit slab_resource(
+        memory_resource     *upstream = get_default_resource(),
+        const slab_options&  options  = {});
+
+    slab_resource(const slab_resource&) = delete;
+    slab_resource& operator=(const slab_resource&) = delete;
+
+    // Return all slabs to the upstream resource.  No thread may be using the
+    // resource at that time.
+    ~slab_resource();
+
+    memory_resource *upstream_resource() const noexcept
+        { return m_upstream_p; }
+
+    const slab_options& options() const noexcept { return m_options; }
+
+    // Return the number of slabs obtained from the upstream resource.
+    size_t slab_count() const;
+
+  private:
+    // A free block holds the link of its free list.
+    struct free_block
+    {
+        std::atomic<free_block*> m_next;
+    };
+
+    static constexpr size_t   min_block_size = sizeof(free_block);
+    static constexpr int      tag_shift      = 48;
+    static constexpr uint64_t pointer_mask   = (uint64_t(1) << tag_shift) - 1;
+
+    static_assert(sizeof(void*) == sizeof(uint64_t),
+                  "Tagged free-list heads require 64-bit pointers");
+
+    struct alignas(64) free_list
+    {
+        std::atomic<uint64_t> m_head{0};  // Tag and `free_block*`
+    };
+
+    memory_resource *m_upstream_p;
+    slab_options     m_options;
+    int              m_num_size_classes;
+
+    std::unique_ptr<free_list[]> m_lists;  // Stripes of each size class
+
+    mutable std::mutex  m_upstream_mutex;  // Guards the below and upstream
+    std::vector<void*>  m_slabs;
+
+    static free_block *pointer(uint64_t head) noexcept
+        { return reinterpret_cast<free_block*>(head & pointer_mask); }
+    static uint64_t next_head(uint64_t head, free_block *p) noexcept
+        { return ((head >> tag_shift) + 1) << tag_shift |
+                 reinterpret_cast<uintptr_t>(p); }
+
+    // Push the chain of blocks from `first` to `last` (already linked to
+    // each other) onto `list`.
+    static void push(free_list& list, free_block *first, free_block *last)
+        noexcept;
+
+    // Pop a block from `list`, or return null if it is empty.
+    static free_block *pop(free_list& list) noexcept;
+
+    size_t stripe() const noexcept;
+
+    // Return the index of the size class for `bytes` and `alignment`, or -1
+    // if the request is not served from slabs.
+    int size_class(size_t bytes, size_t alignment) const noexcept;
+
+    // Obtain a new slab for size class `index`, push all but one of its
+    // blocks onto `list`, and return the remaining one.
+    free_block *refill(int index, free_list& list);
+
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const memory_resource& other) const noexcept override;
+};
+
+END_NAMESPACE_XPMR
+
+///////////////////////////////////////////////////////////////////////////////
+// INLINE AND TEMPLATE FUNCTION IMPLEMENTATIONS
+///////////////////////////////////////////////////////////////////////////////
+
+inline XPMR::slab_resource::slab_resource(memory_resource     *upstream,
+                                          const slab_options&  options)
+    : m_upstream_p(upstream)
+    , m_options(options)
+{
+    if (m_options.max_block_size < min_block_size)
+        m_options.max_block_size = min_block_size;
+    m_options.max_block_size = std::bit_ceil(m_options.max_block_size);
+    if (m_options.slab_size < m_options.max_block_size)
+        m_options.slab_size = m_options.max_block_size;
+    if (m_options.stripes < 1)
+        m_options.stripes = 1;
+
+    m_num_size_classes = (std::bit_width(m_options.max_block_size) -
+                          std::bit_width(min_block_size) + 1);
+    m_lists.reset(new free_list[m_num_size_classes * m_options.stripes]);
+}
+
+inline XPMR::slab_resource::~slab_resource()
+{
+    for (void *slab : m_slabs) {
+        m_upstream_p->deallocate(slab, m_options.slab_size,
+                                 m_options.max_block_size);
+    }
+}
+
+inline size_t XPMR::slab_resource::slab_count() const
+{
+    std::lock_guard<std::mutex> guard(m_upstream_mutex);
+    return m_slabs.size();
+}
+
+inline void XPMR::slab_resource::
+push(free_list& list, free_block *first, free_block *last) noexcept
+{
+    uint64_t head = list.m_head.load(memory_order_relaxed);
+    do {
+        last->m_next.store(pointer(head), memory_order_relaxed);
+    } while (! list.m_head.compare_exchange_weak(head, next_head(head, first),
+                                                 memory_order_release,
+                                                 memory_order_relaxed));
+}
+
+inline XPMR::slab_resource::free_block *
+XPMR::slab_resource::pop(free_list& list) noexcept
+{
+    uint64_t head = list.m_head.load(memory_order_acquire);
+    while (free_block *block = pointer(head)) {
+        // If `block` has been popped by another thread since `head` was
+        // read, `next` may be garbage, but then the tag has changed and the
+        // exchange fails.
+        free_block *next = block->m_next.load(memory_order_relaxed);
+        if (list.m_head.compare_exchange_weak(head, next_head(head, next),
+                                              memory_order_acquire,
+                                              memory_order_acquire))
+            return block;                                             // RETURN
+    }
+    return nullptr;
+}
+
+inline size_t XPMR::slab_resource::stripe() const noexcept
+{
+    static std::atomic<size_t> next_thread{0};
+    static thread_local size_t thread_index =
+        next_thread.fetch_add(1, memory_order_relaxed);
+    return thread_index % m_options.stripes;
+}
+
+inline int XPMR::slab_resource::
+size_class(size_t bytes, size_t alignment) const noexcept
+{
+    // Blocks are aligned to their size, so the alignment only raises the
+    // size class.
+    size_t block_size = bytes < alignment ? alignment : bytes;
+    if (block_size > m_options.max_block_size)
+        return -1;
+    if (block_size < min_block_size)
+        block_size = min_block_size;
+    return std::bit_width(block_size - 1) - std::bit_width(min_block_size - 1);
+}
+
+inline XPMR::slab_resource::free_block *
+XPMR::slab_resource::refill(int index, free_list& list)
+{
+    const size_t block_size = min_block_size << index;
+    const size_t num_blocks = m_options.slab_size / block_size;
+
+    char *slab;
+    {
+        std::lock_guard<std::mutex> guard(m_upstream_mutex);
+        // Reserve before allocating so that recording the slab cannot
+        // throw, growing geometrically to keep refills amortized O(1).
+        if (m_slabs.size() == m_slabs.capacity())
+            m_slabs.reserve(2 * m_slabs.size() + 8);
+        slab = static_cast<char*>(
+            m_upstream_p->allocate(m_options.slab_size,
+                                   m_options.max_block_size));
+        if (reinterpret_cast<uintptr_t>(slab) + m_options.slab_size >
+            pointer_mask) {
+            m_upstream_p->deallocate(slab, m_options.slab_size,
+                                     m_options.max_block_size);
+            throw std::bad_alloc();
+        }
+        m_slabs.push_back(slab);
+    }
+
+    // Link blocks 1 through `num_blocks - 1` in address order and push them
+    // with a single exchange.
+    free_block *first = ::new (slab) free_block{ { nullptr } };
+    if (num_blocks > 1) {
+        free_block *prev = nullptr;
+        for (size_t i = num_blocks - 1; i > 0; --i) {
+            prev = ::new (slab + i * block_size) free_block{ { prev } };
+        }
+        push(list, prev, reinterpret_cast<free_block*>(
+                             slab + (num_blocks - 1) * block_size));
+    }
+    return first;
+}
+
+inline void *XPMR::slab_resource::do_allocate(size_t bytes, size_t alignment)
+{
+    const int index = size_class(bytes, alignment);
+    if (index < 0) {
+        std::lock_guard<std::mutex> guard(m_upstream_mutex);
+        return m_upstream_p->allocate(bytes, alignment);              // RETURN
+    }
+
+    free_list *lists = &m_lists[index * m_options.stripes];
+    const size_t own = stripe();
+    for (size_t i = 0; i < m_options.stripes; ++i) {
+        const size_t s = own + i < m_options.stripes ?
+                         own + i : own + i - m_options.stripes;
+        if (free_block *block = pop(lists[s]))
+            return block;                                             // RETURN
+    }
+
+    return refill(index, lists[own]);
+}
+
+inline void XPMR::slab_resource::
+do_deallocate(void *p, size_t bytes, size_t alignment)
+{
+    const int index = size_class(bytes, alignment);
+    if (index < 0) {
+        std::lock_guard<std::mutex> guard(m_upstream_mutex);
+        m_upstream_p->deallocate(p, bytes, alignment);
+        return;                                                       // RETURN
+    }
+
+    free_block *block = ::new (p) free_block{ { nullptr } };
+    push(m_lists[index * m_options.stripes + stripe()], block, block);
+}
+
+inline bool XPMR::slab_resource::
+do_is_equal(const memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+#endif // ! defined(INCLUDED_SLAB_RESOURCE_DOT_H)
@@ -0,0 +1,245 @@
+// slab_resource.t.cpp                                                -*-C++-*-
+
+#define RA_SWITCH 1
+
+#include "slab_resource.h"
+#include <resource_adaptor.h>
+
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <set>
+#include <thread>
+#include <vector>
+
+//==========================================================================
+//                  ASSERT TEST MACRO
+//--------------------------------------------------------------------------
+static int testStatus = 0;
+
+static void aSsErT(int c, const char *s, int i) {
+    if (c) {
+        std::cout << __FILE__ << ":" << i << ": error: " << s
+                  << "    (failed)" << std::endl;
+        if (testStatus >= 0 && testStatus <= 100) ++testStatus;
+    }
+}
+
+# define TEST_ASSERT(X) { aSsErT(!(X), #X, __LINE__); }
+
+//=============================================================================
+//                  CLASSES FOR TESTING
+//-----------------------------------------------------------------------------
+
+// Memory resource that counts the blocks and bytes outstanding.  It is not
+// thread-safe, which `slab_resource` must accommodate.
+class TestResource : public std::pmr::memory_resource
+{
+  public:
+    std::size_t d_allocations   = 0;
+    std::size_t d_deallocations = 0;
+    std::size_t d_liveBytes     = 0;
+
+  private:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+        ++d_allocations;
+        d_liveBytes += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *p, std::size_t bytes, std::size_t alignment)
+        override {
+        ++d_deallocations;
+        d_liveBytes -= bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+        { return this == &other; }
+};
+
+bool isAligned(void *p, std::size_t alignment)
+{
+    return 0 == reinterpret_cast<std::uintptr_t>(p) % alignment;
+}
+
+//=============================================================================
+//                              MAIN PROGRAM
+//-----------------------------------------------------------------------------
+
+int main()
+{
+    using XPMR::slab_resource;
+    using XPMR::slab_options;
+
+    {
+        // Size classes, slabs, and reuse
+
+        TestResource upstream;
+        slab_options options;
+        options.max_block_size = 256;
+        options.slab_size      = 4096;
+        options.stripes        = 1;
+
+        {
+            slab_resource srx(&upstream, options);
+            TEST_ASSERT(srx.upstream_resource() == &upstream);
+            TEST_ASSERT(0 == srx.slab_count());
+
+            // The first allocation of a size class obtains a slab.
+            void *p1 = srx.allocate(20, 4);
+            TEST_ASSERT(1 == upstream.d_allocations);
+            TEST_ASSERT(1 == srx.slab_count());
+            TEST_ASSERT(isAligned(p1, 32));
+
+            // Same size class: carved from the same slab, in address order
+            void *p2 = srx.allocate(32, 8);
+            TEST_ASSERT(1 == upstream.d_allocations);
+            TEST_ASSERT(static_cast<char*>(p2) == static_cast<char*>(p1) + 32);
+
+            // Alignment raises the size class.
+            void *p3 = srx.allocate(8, 64);
+            TEST_ASSERT(2 == srx.slab_count());
+            TEST_ASSERT(isAligned(p3, 64));
+
+            // Small requests share the smallest size class.
+            void *p4 = srx.allocate(1, 1);
+            TEST_ASSERT(3 == srx.slab_count());
+            TEST_ASSERT(isAligned(p4, alignof(void*)));
+
+            // Deallocated blocks are reused, last in first out.
+            srx.deallocate(p2, 32, 8);
+            TEST_ASSERT(srx.allocate(25, 1) == p2);
+
+            // A slab of 4096 bytes holds 128 blocks of 32 bytes.
+            std::vector<void*> blocks;
+            for (int i = 0; i < 126; ++i) {
+                blocks.push_back(srx.allocate(32, 8));
+            }
+            TEST_ASSERT(3 == srx.slab_count());
+            blocks.push_back(srx.allocate(32, 8));
+            TEST_ASSERT(4 == srx.slab_count());
+            std::set<void*> distinct(blocks.begin(), blocks.end());
+            distinct.insert(p1);
+            distinct.insert(p2);
+            TEST_ASSERT(129 == distinct.size());
+            for (void *p : blocks) {
+                srx.deallocate(p, 32, 8);
+            }
+
+            // Too large: passed through to upstream
+            void *big = srx.allocate(257, 8);
+            TEST_ASSERT(5 == upstream.d_allocations);
+            TEST_ASSERT(4 == srx.slab_count());
+            srx.deallocate(big, 257, 8);
+            TEST_ASSERT(1 == upstream.d_deallocations);
+
+            srx.deallocate(p1, 20, 4);
+            srx.deallocate(p2, 25, 1);
+            srx.deallocate(p3, 8, 64);
+            srx.deallocate(p4, 1, 1);
+            TEST_ASSERT(1 == upstream.d_deallocations);  // Slabs are kept
+        }
+
+        // Slabs are returned on destruction.
+        TEST_ASSERT(0 == upstream.d_liveBytes);
+        TEST_ASSERT(upstream.d_allocations == upstream.d_deallocations);
+    }
+
+    {
+        // Blocks are handed to one owner at a time, with threads allocating,
+        // and freeing blocks allocated by other threads, concurrently.
+
+        constexpr int numThreads = 4;
+        constexpr int numBlocks  = 2000;
+        constexpr int numRounds  = 20;
+
+        TestResource upstream;
+        slab_options options;
+        options.slab_size = 1024;
+        options.stripes   = 3;  // Fewer than the threads
+        slab_resource srx(&upstream, options);
+
+        std::vector<unsigned char *> handoff[numThreads];
+        std::atomic<int> errors{0};
+        std::atomic<int> arrived{0};
+
+        auto barrier = [&arrived](int generation) {
+            arrived.fetch_add(1);
+            while (arrived.load() < generation * numThreads) {
+                std::this_thread::yield();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < numThreads; ++t) {
+            threads.emplace_back([&, t] {
+                int generation = 0;
+                for (int round = 0; round < numRounds; ++round) {
+                    // Fill each block with a pattern unique to its owner.
+                    const unsigned char mark = (t * numRounds + round) % 255;
+                    std::vector<unsigned char *> mine;
+                    for (int i = 0; i < numBlocks; ++i) {
+                        const std::size_t bytes = 16 + 16 * (i % 4);
+                        auto p = static_cast<unsigned char *>(
+                            srx.allocate(bytes, 8));
+                        std::memset(p, mark, bytes);
+                        mine.push_back(p);
+                    }
+                    for (int i = 0; i < numBlocks; ++i) {
+                        const std::size_t bytes = 16 + 16 * (i % 4);
+                        for (std::size_t b = 0; b < bytes; ++b) {
+                            if (mine[i][b] != mark) {
+                                ++errors;
+                                break;
+                            }
+                        }
+                    }
+                    handoff[t] = std::move(mine);
+                    barrier(++generation);
+
+                    // Free the blocks of the next thread.
+                    const auto& theirs = handoff[(t + 1) % numThreads];
+                    for (int i = 0; i < numBlocks; ++i) {
+                        srx.deallocate(theirs[i], 16 + 16 * (i % 4), 8);
+                    }
+                    barrier(++generation);
+                }
+            });
+        }
+        for (std::thread& th : threads) {
+            th.join();
+        }
+
+        TEST_ASSERT(0 == errors.load());
+        TEST_ASSERT(0 == upstream.d_deallocations);
+    }
+
+    {
+        // As the resource of a node-based container, in front of a
+        // `resource_adaptor`
+
+        XPMR::resource_adaptor<std::allocator<char>> adaptor;
+        slab_resource srx(&adaptor);
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&srx] {
+                std::pmr::list<int> lst(&srx);
+                for (int i = 0; i < 10000; ++i) {
+                    lst.push_back(i);
+                    if (i % 3 == 0) lst.pop_front();
+                }
+                TEST_ASSERT(6666 == lst.size());
+                TEST_ASSERT(9999 == lst.back());
+            });
+        }
+        for (std::thread& th : threads) {
+            th.join();
+        }
+        TEST_ASSERT(srx.slab_count() > 0);
+    }
+
+    return testStatus;
+}
@@ -0,0 +1,375 @@
+/* statistics_resource.h                  -*-C++-*-
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ *    (See accompanying file LICENSE_1_0.txt or copy at
+ *          http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+/* This component defines `statistics_resource`, a `memory_resource` that
+ * forwards every request to an upstream resource and records what passes
+ * through it: allocation and deallocation counts, byte totals, histograms of
+ * request sizes and alignments, live blocks and bytes, a high-water mark of
+ * live bytes, and a histogram of sampled allocation lifetimes.  A consistent
+ * copy of the statistics is obtained with `snapshot` and the counters are
+ * cleared with `reset`.
+ *
+ * It is intended to stay enabled in production-like runs, so the counters are
+ * spread over shards, each on its own cache lines, with threads assigned to
+ * shards round robin; an allocation updates only its thread's shard with
+ * relaxed atomic increments.  The high-water mark is refreshed by summing the
+ * shards only periodically (see `statistics_options`), so it can miss short
+ * peaks.  Lifetimes are measured for about one block in
+ * `lifetime_sample_period`, chosen by a hash of its address, so that the
+ * deallocation of an unsampled block costs only the hash.  The sample is
+ * therefore biased when the upstream resource reuses the most recently freed
+ * blocks first, as most pools do: a few hot addresses are then either
+ * sampled on every reuse or never, so the lifetime histogram may over- or
+ * under-represent the short-lived blocks that occupy them.  The start times of
+ * sampled blocks are kept in per-shard tables selected by the same hash, so
+ * that a block is found whichever thread deallocates it.  If a start time
+ * cannot be recorded for lack of memory, that block is not sampled.
+ */
+
+#ifndef INCLUDED_STATISTICS_RESOURCE_DOT_H
+#define INCLUDED_STATISTICS_RESOURCE_DOT_H
+
+#include <xstd.h>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <unordered_map>
+
+BEGIN_NAMESPACE_XPMR
+
+// Tuning of a `statistics_resource`.
+struct statistics_options
+{
+    // Number of independently updated sets of counters.
+    size_t shards = 16;
+
+    // The high-water mark of live bytes is refreshed on every
+    // `peak_check_interval`-th allocation in each shard and on every
+    // allocation of at least `peak_check_bytes` bytes.
+    size_t peak_check_interval = 64;
+    size_t peak_check_bytes    = 64 * 1024;
+
+    // About one block in `lifetime_sample_period` has its lifetime measured.
+    // Zero disables lifetime sampling.
+    size_t lifetime_sample_period = 64;
+};
+
+// Statistics recorded by a `statistics_resource` since construction or the
+// last `reset`.  In the size and lifetime histograms, bucket `i` counts the
+// values `v` for which `std::bit_width(v) == i` (i.e., `0` in bucket 0 and
+// `[2^(i-1), 2^i)` in bucket `i`).  In the alignment histogram, whose values
+// are powers of 2, bucket `i` counts the alignment `2^i`.  In each histogram,
+// the last bucket also counts all larger values.
+struct allocation_statistics
+{
+    static constexpr size_t num_size_buckets     = 32;
+    static constexpr size_t num_align_buckets    = 16;
+    static constexpr size_t num_lifetime_buckets = 48;
+
+    uint64_t allocations;
+    uint64_t deallocations;
+    uint64_t bytes_allocated;
+    uint64_t bytes_deallocated;
+
+    // Blocks and bytes currently allocated, and the largest value of
+    // `live_bytes` observed.  These are not cleared by `reset`.
+    uint64_t live_blocks;
+    uint64_t live_bytes;
+    uint64_t peak_live_bytes;
+
+    uint64_t size_histogram[num_size_buckets];        // Request sizes
+    uint64_t alignment_histogram[num_align_buckets];  // Request alignments
+
+    uint64_t lifetime_samples;                        // Sampled lifetimes
+    uint64_t lifetime_histogram[num_lifetime_buckets];  // ...in ns
+};
+
+class statistics_resource : public memory_resource
+{
+  public:
+    explicit statistics_resource(
+        memory_resource           *upstream = get_default_resource(),
+        const statistics_options&  options  = {});
+
+    statistics_resource(const statistics_resource&) = delete;
+    statistics_resource& operator=(const statistics_resource&) = delete;
+
+    memory_resource *upstream_resource() const noexcept
+        { return m_upstream_p; }
+
+    const statistics_options& options() const noexcept { return m_options; }
+
+    // Return the sum of the statistics of all shards.  The high-water mark
+    // is refreshed first.  Counters updated while the shards are being read
+    // may or may not be included.
+    allocation_statistics snapshot() const;
+
+    // Clear the counts, byte totals, and histograms, and set the high-water
+    // mark to the current live bytes.  The lifetimes of sampled blocks that
+    // are still allocated are recorded when they are deallocated.
+    void reset();
+
+  private:
+    using stats = allocation_statistics;
+    using clock = std::chrono::steady_clock;
+
+    struct alignas(64) shard
+    {
+        std::atomic<uint64_t> m_allocations{0};
+        std::atomic<uint64_t> m_deallocations{0};
+        std::atomic<uint64_t> m_bytes_allocated{0};
+        std::atomic<uint64_t> m_bytes_deallocated{0};
+
+        // Signed because a block may be deallocated through another shard.
+        std::atomic<int64_t>  m_live_blocks{0};
+        std::atomic<int64_t>  m_live_bytes{0};
+
+        std::atomic<uint64_t> m_size_histogram[stats::num_size_buckets]{};
+        std::atomic<uint64_t> m_alignment_histogram[stats::num_align_buckets]{};
+        std::atomic<uint64_t> m_lifetime_samples{0};
+        std::atomic<uint64_t> m_lifetime_histogram[
+                                            stats::num_lifetime_buckets]{};
+
+        // Start times of the sampled blocks whose address hashes to this
+        // shard, on cache lines of their own.
+        alignas(64) std::mutex                       m_samples_mutex;
+        std::unordered_map<void*, clock::time_point> m_samples;
+    };
+
+    memory_resource          *m_upstream_p;
+    statistics_options        m_options;
+    std::unique_ptr<shard[]>  m_shards;
+
+    mutable std::atomic<uint64_t> m_peak_live_bytes{0};
+
+    static size_t bucket(uint64_t value, size_t num_buckets) noexcept;
+    static void add(std::atomic<uint64_t>& counter, uint64_t n) noexcept
+        { counter.fetch_add(n, memory_order_relaxed); }
+
+    shard& local_shard() noexcept;
+    shard *sample_shard(void *p) const noexcept;
+    void update_peak() const noexcept;
+
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const memory_resource& other) const noexcept override;
+};
+
+END_NAMESPACE_XPMR
+
+///////////////////////////////////////////////////////////////////////////////
+// INLINE AND TEMPLATE FUNCTION IMPLEMENTATIONS
+///////////////////////////////////////////////////////////////////////////////
+
+inline XPMR::statistics_resource::statistics_resource(
+    memory_resource *upstream, const statistics_options& options)
+    : m_upstream_p(upstream)
+    , m_options(options)
+{
+    if (m_options.shards < 1)
+        m_options.shards = 1;
+    if (m_options.peak_check_interval < 1)
+        m_options.peak_check_interval = 1;
+
+    m_shards.reset(new shard[m_options.shards]);
+}
+
+inline size_t XPMR::statistics_resource::
+bucket(uint64_t value, size_t num_buckets) noexcept
+{
+    const size_t i = std::bit_width(value);
+    return i < num_buckets ? i : num_buckets - 1;
+}
+
+inline XPMR::statistics_resource::shard&
+XPMR::statistics_resource::local_shard() noexcept
+{
+    static std::atomic<size_t> next_thread{0};
+    static thread_local size_t thread_index =
+        next_thread.fetch_add(1, memory_order_relaxed);
+    return m_shards[thread_index % m_options.shards];
+}
+
+// Return the shard holding the start time of `p` if `p` is sampled, and null
+// otherwise.
+inline XPMR::statistics_resource::shard *
+XPMR::statistics_resource::sample_shard(void *p) const noexcept
+{
+    if (0 == m_options.lifetime_sample_period)
+        return nullptr;
+
+    // Fibonacci hashing of the address, ignoring the low bits that are
+    // usually zero because of alignment.
+    const uint64_t h =
+        (uint64_t(reinterpret_cast<uintptr_t>(p)) >> 4) *
+        0x9E3779B97F4A7C15ULL;
+    const uint64_t period = m_options.lifetime_sample_period;
+    if (0 != (h >> 32) % period)
+        return nullptr;
+
+    return &m_shards[(h >> 32) / period % m_options.shards];
+}
+
+inline void XPMR::statistics_resource::update_peak() const noexcept
+{
+    int64_t live = 0;
+    for (size_t i = 0; i < m_options.shards; ++i)
+        live += m_shards[i].m_live_bytes.load(memory_order_relaxed);
+    if (live < 0)
+        return;                                                       // RETURN
+
+    uint64_t peak = m_peak_live_bytes.load(memory_order_relaxed);
+    while (uint64_t(live) > peak &&
+           ! m_peak_live_bytes.compare_exchange_weak(peak, uint64_t(live),
+                                                     memory_order_relaxed)) {
+    }
+}
+
+inline XPMR::allocation_statistics
+XPMR::statistics_resource::snapshot() const
+{
+    update_peak();
+
+    allocation_statistics result{};
+    int64_t live_blocks = 0, live_bytes = 0;
+    for (size_t i = 0; i < m_options.shards; ++i) {
+        const shard& s = m_shards[i];
+        result.allocations       += s.m_allocations.load(memory_order_relaxed);
+        result.deallocations     +=
+            s.m_deallocations.load(memory_order_relaxed);
+        result.bytes_allocated   +=
+            s.m_bytes_allocated.load(memory_order_relaxed);
+        result.bytes_deallocated +=
+            s.m_bytes_deallocated.load(memory_order_relaxed);
+        live_blocks += s.m_live_blocks.load(memory_order_relaxed);
+        live_bytes  += s.m_live_bytes.load(memory_order_relaxed);
+
+        for (size_t b = 0; b < stats::num_size_buckets; ++b)
+            result.size_histogram[b] +=
+                s.m_size_histogram[b].load(memory_order_relaxed);
+        for (size_t b = 0; b < stats::num_align_buckets; ++b)
+            result.alignment_histogram[b] +=
+                s.m_alignment_histogram[b].load(memory_order_relaxed);
+        result.lifetime_samples +=
+            s.m_lifetime_samples.load(memory_order_relaxed);
+        for (size_t b = 0; b < stats::num_lifetime_buckets; ++b)
+            result.lifetime_histogram[b] +=
+                s.m_lifetime_histogram[b].load(memory_order_relaxed);
+    }
+
+    result.live_blocks     = live_blocks > 0 ? uint64_t(live_blocks) : 0;
+    result.live_bytes      = live_bytes  > 0 ? uint64_t(live_bytes)  : 0;
+    result.peak_live_bytes = m_peak_live_bytes.load(memory_order_relaxed);
+    if (result.peak_live_bytes < result.live_bytes)
+        result.peak_live_bytes = result.live_bytes;
+
+    return result;
+}
+
+inline void XPMR::statistics_resource::reset()
+{
+    for (size_t i = 0; i < m_options.shards; ++i) {
+        shard& s = m_shards[i];
+        s.m_allocations.store(0, memory_order_relaxed);
+        s.m_deallocations.store(0, memory_order_relaxed);
+        s.m_bytes_allocated.store(0, memory_order_relaxed);
+        s.m_bytes_deallocated.store(0, memory_order_relaxed);
+        for (auto& counter : s.m_size_histogram)
+            counter.store(0, memory_order_relaxed);
+        for (auto& counter : s.m_alignment_histogram)
+            counter.store(0, memory_order_relaxed);
+        s.m_lifetime_samples.store(0, memory_order_relaxed);
+        for (auto& counter : s.m_lifetime_histogram)
+            counter.store(0, memory_order_relaxed);
+    }
+
+    m_peak_live_bytes.store(0, memory_order_relaxed);
+    update_peak();
+}
+
+inline void *XPMR::statistics_resource::
+do_allocate(size_t bytes, size_t alignment)
+{
+    void *p = m_upstream_p->allocate(bytes, alignment);
+
+    shard& s = local_shard();
+    const uint64_t count =
+        s.m_allocations.fetch_add(1, memory_order_relaxed) + 1;
+    add(s.m_bytes_allocated, bytes);
+    s.m_live_blocks.fetch_add(1, memory_order_relaxed);
+    s.m_live_bytes.fetch_add(int64_t(bytes), memory_order_relaxed);
+    add(s.m_size_histogram[bucket(bytes, stats::num_size_buckets)], 1);
+    // `bit_width(alignment)` is log2(alignment) + 1, so shift it down.
+    add(s.m_alignment_histogram[bucket(alignment >> 1,
+                                       stats::num_align_buckets)], 1);
+
+    if (0 == count % m_options.peak_check_interval ||
+        bytes >= m_options.peak_check_bytes)
+        update_peak();
+
+    if (shard *ss = sample_shard(p)) {
+        const clock::time_point now = clock::now();
+        try {
+            std::lock_guard<std::mutex> guard(ss->m_samples_mutex);
+            ss->m_samples.insert_or_assign(p, now);
+        }
+        catch (...) {
+            // Skip the sample rather than lose `p`.
+        }
+    }
+
+    return p;
+}
+
+inline void XPMR::statistics_resource::
+do_deallocate(void *p, size_t bytes, size_t alignment)
+{
+    if (shard *ss = sample_shard(p)) {
+        const clock::time_point now = clock::now();
+        clock::time_point       start;
+        bool                    found = false;
+        {
+            std::lock_guard<std::mutex> guard(ss->m_samples_mutex);
+            auto it = ss->m_samples.find(p);
+            if (it != ss->m_samples.end()) {
+                start = it->second;
+                found = true;
+                ss->m_samples.erase(it);
+            }
+        }
+
+        if (found) {
+            const auto ns = std::chrono::duration_cast<
+                std::chrono::nanoseconds>(now - start).count();
+            shard& s = local_shard();
+            add(s.m_lifetime_samples, 1);
+            add(s.m_lifetime_histogram[bucket(uint64_t(ns),
+                                       stats::num_lifetime_buckets)], 1);
+        }
+    }
+
+    shard& s = local_shard();
+    add(s.m_deallocations, 1);
+    add(s.m_bytes_deallocated, bytes);
+    s.m_live_blocks.fetch_sub(1, memory_order_relaxed);
+    s.m_live_bytes.fetch_sub(int64_t(bytes), memory_order_relaxed);
+
+    m_upstream_p->deallocate(p, bytes, alignment);
+}
+
+inline bool XPMR::statistics_resource::
+do_is_equal(const memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+#endif // ! defined(INCLUDED_STATISTICS_RESOURCE_DOT_H)
@@ -0,0 +1,254 @@
+// statistics_resource.t.cpp                                          -*-C++-*-
+
+#define RA_SWITCH 1
+
+#include "statistics_resource.h"
+#include <resource_adaptor.h>
+
+#include <iostream>
+#include <list>
+#include <thread>
+#include <vector>
+
+//==========================================================================
+//                  ASSERT TEST MACRO
+//--------------------------------------------------------------------------
+static int testStatus = 0;
+
+static void aSsErT(int c, const char *s, int i) {
+    if (c) {
+        std::cout << __FILE__ << ":" << i << ": error: " << s
+                  << "    (failed)" << std::endl;
+        if (testStatus >= 0 && testStatus <= 100) ++testStatus;
+    }
+}
+
+# define TEST_ASSERT(X) { aSsErT(!(X), #X, __LINE__); }
+
+//=============================================================================
+//                  CLASSES FOR TESTING
+//-----------------------------------------------------------------------------
+
+// Thread-safe memory resource that counts the blocks outstanding and checks
+// the alignment of each block it returns.
+class TestResource : public std::pmr::memory_resource
+{
+  public:
+    std::atomic<long> d_blocks{0};
+
+  private:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+        ++d_blocks;
+        void *p = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        TEST_ASSERT(0 == reinterpret_cast<std::uintptr_t>(p) % alignment);
+        return p;
+    }
+
+    void do_deallocate(void *p, std::size_t bytes, std::size_t alignment)
+        override {
+        --d_blocks;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+        { return this == &other; }
+};
+
+//=============================================================================
+//                              MAIN PROGRAM
+//-----------------------------------------------------------------------------
+
+int main()
+{
+    using XPMR::statistics_resource;
+    using XPMR::statistics_options;
+    using XPMR::allocation_statistics;
+
+    {
+        // Counts, byte totals, histograms, and the high-water mark
+
+        TestResource upstream;
+        statistics_options options;
+        options.peak_check_interval = 1;
+        statistics_resource srx(&upstream, options);
+        TEST_ASSERT(srx.upstream_resource() == &upstream);
+
+        allocation_statistics stats = srx.snapshot();
+        TEST_ASSERT(0 == stats.allocations);
+        TEST_ASSERT(0 == stats.live_bytes);
+        TEST_ASSERT(0 == stats.peak_live_bytes);
+
+        void *p1 = srx.allocate(1, 1);      // Size bucket 1, alignment 0
+        void *p2 = srx.allocate(24, 8);     // Size bucket 5, alignment 3
+        void *p3 = srx.allocate(32, 64);    // Size bucket 6, alignment 6
+        void *p4 = srx.allocate(100000, 8); // Size bucket 17, alignment 3
+        TEST_ASSERT(4 == upstream.d_blocks);
+        TEST_ASSERT(0 == reinterpret_cast<std::uintptr_t>(p3) % 64);
+
+        stats = srx.snapshot();
+        TEST_ASSERT(4 == stats.allocations);
+        TEST_ASSERT(0 == stats.deallocations);
+        TEST_ASSERT(100057 == stats.bytes_allocated);
+        TEST_ASSERT(4 == stats.live_blocks);
+        TEST_ASSERT(100057 == stats.live_bytes);
+        TEST_ASSERT(100057 == stats.peak_live_bytes);
+        TEST_ASSERT(1 == stats.size_histogram[1]);
+        TEST_ASSERT(1 == stats.size_histogram[5]);
+        TEST_ASSERT(1 == stats.size_histogram[6]);
+        TEST_ASSERT(1 == stats.size_histogram[17]);
+        TEST_ASSERT(1 == stats.alignment_histogram[0]);
+        TEST_ASSERT(2 == stats.alignment_histogram[3]);
+        TEST_ASSERT(1 == stats.alignment_histogram[6]);
+
+        srx.deallocate(p4, 100000, 8);
+        stats = srx.snapshot();
+        TEST_ASSERT(1 == stats.deallocations);
+        TEST_ASSERT(100000 == stats.bytes_deallocated);
+        TEST_ASSERT(3 == stats.live_blocks);
+        TEST_ASSERT(57 == stats.live_bytes);
+        TEST_ASSERT(100057 == stats.peak_live_bytes);
+
+        // `reset` clears everything but the live counts, and restarts the
+        // high-water mark from the current live bytes.
+        srx.reset();
+        stats = srx.snapshot();
+        TEST_ASSERT(0 == stats.allocations);
+        TEST_ASSERT(0 == stats.deallocations);
+        TEST_ASSERT(0 == stats.bytes_allocated);
+        TEST_ASSERT(0 == stats.size_histogram[17]);
+        TEST_ASSERT(0 == stats.alignment_histogram[3]);
+        TEST_ASSERT(3 == stats.live_blocks);
+        TEST_ASSERT(57 == stats.live_bytes);
+        TEST_ASSERT(57 == stats.peak_live_bytes);
+
+        srx.deallocate(p1, 1, 1);
+        srx.deallocate(p2, 24, 8);
+        srx.deallocate(p3, 32, 64);
+        stats = srx.snapshot();
+        TEST_ASSERT(3 == stats.deallocations);
+        TEST_ASSERT(0 == stats.live_blocks);
+        TEST_ASSERT(0 == stats.live_bytes);
+        TEST_ASSERT(0 == upstream.d_blocks);
+
+        // Large alignments fall into the last bucket.
+        void *p5 = srx.allocate(8, std::size_t(1) << 16);
+        TEST_ASSERT(1 == srx.snapshot().alignment_histogram[
+                             allocation_statistics::num_align_buckets - 1]);
+        srx.deallocate(p5, 8, std::size_t(1) << 16);
+    }
+
+    {
+        // Lifetime sampling
+
+        TestResource upstream;
+        statistics_options options;
+        options.lifetime_sample_period = 1;  // Sample every block
+        statistics_resource srx(&upstream, options);
+
+        std::vector<void*> blocks;
+        for (int i = 0; i < 100; ++i) {
+            blocks.push_back(srx.allocate(16, 8));
+        }
+        srx.deallocate(blocks[0], 16, 8);
+        TEST_ASSERT(1 == srx.snapshot().lifetime_samples);
+        for (int i = 1; i < 100; ++i) {
+            srx.deallocate(blocks[i], 16, 8);
+        }
+
+        allocation_statistics stats = srx.snapshot();
+        TEST_ASSERT(100 == stats.lifetime_samples);
+        uint64_t total = 0;
+        for (uint64_t n : stats.lifetime_histogram) {
+            total += n;
+        }
+        TEST_ASSERT(100 == total);
+
+        // With the default period, only some blocks are sampled.
+        statistics_resource sampled(&upstream);
+        for (void *&p : blocks) {
+            p = sampled.allocate(16, 8);
+        }
+        for (void *p : blocks) {
+            sampled.deallocate(p, 16, 8);
+        }
+        TEST_ASSERT(sampled.snapshot().lifetime_samples < 100);
+
+        // Sampling can be disabled.
+        options.lifetime_sample_period = 0;
+        statistics_resource unsampled(&upstream, options);
+        unsampled.deallocate(unsampled.allocate(16, 8), 16, 8);
+        TEST_ASSERT(0 == unsampled.snapshot().lifetime_samples);
+        TEST_ASSERT(1 == unsampled.snapshot().deallocations);
+    }
+
+    {
+        // Threads, including cross-thread deallocation, with more threads
+        // than shards
+
+        TestResource upstream;
+        statistics_options options;
+        options.shards = 3;
+        options.lifetime_sample_period = 1;
+        statistics_resource srx(&upstream, options);
+
+        std::vector<void*> fromThreads[4];
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&srx, &out = fromThreads[t]] {
+                std::pmr::list<int> lst(&srx);
+                for (int i = 0; i < 1000; ++i) {
+                    lst.push_back(i);
+                    if (i % 3 == 0) lst.pop_front();
+                }
+                for (int i = 0; i < 100; ++i) {
+                    out.push_back(srx.allocate(48, 16));
+                }
+            });
+        }
+        for (std::thread& th : threads) {
+            th.join();
+        }
+
+        allocation_statistics stats = srx.snapshot();
+        TEST_ASSERT(4 * 1100 == stats.allocations);
+        TEST_ASSERT(4 * 1000 == stats.deallocations);
+        TEST_ASSERT(400 == stats.live_blocks);
+        TEST_ASSERT(400 * 48 == stats.live_bytes);
+        TEST_ASSERT(stats.peak_live_bytes >= stats.live_bytes);
+
+        // Deallocate, in this thread, blocks allocated by the other threads.
+        for (auto& out : fromThreads) {
+            for (void *p : out) {
+                srx.deallocate(p, 48, 16);
+            }
+        }
+        stats = srx.snapshot();
+        TEST_ASSERT(stats.allocations == stats.deallocations);
+        TEST_ASSERT(stats.bytes_allocated == stats.bytes_deallocated);
+        TEST_ASSERT(stats.allocations == stats.lifetime_samples);
+        TEST_ASSERT(0 == stats.live_bytes);
+        TEST_ASSERT(0 == upstream.d_blocks);
+    }
+
+    {
+        // In front of a `resource_adaptor`
+
+        XPMR::resource_adaptor<std::allocator<char>> adaptor;
+        statistics_resource srx(&adaptor);
+
+        {
+            std::pmr::vector<std::pmr::list<double>> v(&srx);
+            for (int i = 0; i < 100; ++i) {
+                v.emplace_back(10, double(i));
+            }
+            TEST_ASSERT(100 == v.size());
+            TEST_ASSERT(99.0 == v.back().front());
+            TEST_ASSERT(srx.snapshot().live_blocks > 1000);
+        }
+        allocation_statistics stats = srx.snapshot();
+        TEST_ASSERT(0 == stats.live_blocks);
+        TEST_ASSERT(stats.peak_live_bytes > 1000 * sizeof(double));
+    }
+
+    return testStatus;
+}
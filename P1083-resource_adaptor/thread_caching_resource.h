@@ -0,0 +1,527 @@
+/* thread_caching_resource.h                  -*-C++-*-
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ *    (See accompanying file LICENSE_1_0.txt or copy at
+ *          http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+/* This component defines `thread_caching_resource`, a `memory_resource` that
+ * keeps, for each thread, a free list of blocks for each (size class,
+ * alignment) pair, in front of an arbitrary upstream resource such as a
+ * `resource_adaptor` for a slow or lock-protected legacy allocator.  A
+ * request is rounded up to a power-of-two size class and served from the
+ * calling thread's free list without synchronization.  An empty list is
+ * refilled with a batch of blocks from the upstream resource, and a list that
+ * grows beyond a bound returns a batch of blocks to it, so the upstream
+ * resource (which is called only under a lock) sees only a small fraction of
+ * the requests.  Requests larger than the largest size class, or more aligned
+ * than `alignof(max_align_t)`, bypass the cache.
+ *
+ * A block may be deallocated by any thread; it is then cached by that
+ * thread.  When a thread exits, its cached blocks are returned to the
+ * upstream resource.  All cached blocks are returned when the resource is
+ * destroyed; no thread may be using the resource at that time.
+ */
+
+#ifndef INCLUDED_THREAD_CACHING_RESOURCE_DOT_H
+#define INCLUDED_THREAD_CACHING_RESOURCE_DOT_H
+
+#include <xstd.h>
+#include <atomic>
+#include <bit>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+BEGIN_NAMESPACE_XPMR
+
+// Bounds on the per-thread caches of a `thread_caching_resource`.
+struct thread_caching_options
+{
+    // Largest request (rounded up to a power of 2) that is cached.
+    size_t max_block_size = 1024;
+
+    // Number of blocks obtained from, or returned to, the upstream resource
+    // at a time.
+    size_t batch_size = 32;
+
+    // Maximum number of blocks cached by one thread for one size class and
+    // alignment.  When it is exceeded, `batch_size` blocks are returned.
+    size_t max_cached_blocks = 128;
+};
+
+// Counts of the activity of a `thread_caching_resource`, summed over all
+// threads.
+struct thread_caching_statistics
+{
+    uint64_t hits;                    // Allocations served from a cache
+    uint64_t misses;                  // Allocations that refilled a cache
+    uint64_t bypasses;                // Allocations too large or aligned
+    uint64_t upstream_allocations;    // Blocks obtained from upstream
+    uint64_t upstream_deallocations;  // Blocks returned to upstream
+    uint64_t cached_blocks;           // Blocks currently in caches
+    uint64_t cached_bytes;            // Bytes currently in caches
+};
+
+class thread_caching_resource : public memory_resource
+{
+  public:
+    explicit thread_caching_resource(
+        memory_resource               *upstream = get_default_resource(),
+        const thread_caching_options&  options  = {});
+
+    thread_caching_resource(const thread_caching_resource&) = delete;
+    thread_caching_resource& operator=(const thread_caching_resource&)
+        = delete;
+
+    ~thread_caching_resource();
+
+    memory_resource *upstream_resource() const noexcept
+        { return m_upstream_p; }
+
+    const thread_caching_options& options() const noexcept
+        { return m_options; }
+
+    // Return all the blocks cached by the calling thread to the upstream
+    // resource.
+    void trim();
+
+    thread_caching_statistics statistics() const;
+
+    // Zero the activity counters of all threads.  The counts of cached
+    // blocks and bytes are not affected.  A thread that is allocating at the
+    // same time may overwrite the reset of its own counters.
+    void reset_statistics();
+
+  private:
+    // Cached blocks hold the link of their free list, so they are at least
+    // as large and as aligned as a pointer.  Smaller alignments share the
+    // free lists for `min_block_align`.
+    static constexpr size_t min_block_size  = sizeof(void*);
+    static constexpr size_t min_block_align = alignof(void*);
+    static constexpr size_t max_cache_align = alignof(max_align_t);
+    static constexpr int    num_align_classes =
+        std::bit_width(max_cache_align) - std::bit_width(min_block_align) + 1;
+
+    // Counter written only by the thread that owns it (so it needs no atomic
+    // read-modify-write), and read by any thread.
+    class counter
+    {
+        std::atomic<uint64_t> m_value{0};
+
+      public:
+        void operator+=(uint64_t n) noexcept
+            { m_value.store(m_value.load(memory_order_relaxed) + n,
+                            memory_order_relaxed); }
+        void operator-=(uint64_t n) noexcept
+            { m_value.store(m_value.load(memory_order_relaxed) - n,
+                            memory_order_relaxed); }
+        void operator++() noexcept { *this += 1; }
+        void operator--() noexcept { *this -= 1; }
+        uint64_t load() const noexcept
+            { return m_value.load(memory_order_relaxed); }
+        void reset() noexcept { m_value.store(0, memory_order_relaxed); }
+    };
+
+    struct free_list
+    {
+        void   *m_head  = nullptr;
+        size_t  m_count = 0;
+    };
+
+    // The free lists and counters of one thread.
+    struct thread_cache
+    {
+        explicit thread_cache(size_t num_lists) : m_lists(num_lists) { }
+
+        std::vector<free_list> m_lists;
+        counter                m_cached_blocks;
+        counter                m_cached_bytes;
+        counter                m_hits;
+        counter                m_misses;
+        counter                m_bypasses;
+        counter                m_upstream_allocations;
+        counter                m_upstream_deallocations;
+    };
+
+    // The caches of the calling thread, keyed by the `m_id` of the resource
+    // that owns them.  When the thread exits, the caches of the resources
+    // that are still alive are returned to them, outside `registry_mutex()`
+    // because the upstream resource may itself be a `thread_caching_resource`
+    // that registers a cache for this thread.  The entries of destroyed
+    // resources are dropped whenever an entry is added.
+    struct thread_registry
+    {
+        std::vector<std::pair<uint64_t, thread_cache*>> m_entries;
+
+        // The most recently used entry, checked first.
+        uint64_t      m_last_id    = ~uint64_t(0);
+        thread_cache *m_last_cache = nullptr;
+
+        ~thread_registry();
+    };
+
+    memory_resource        *m_upstream_p;
+    thread_caching_options  m_options;
+    int                     m_num_size_classes;
+    uint64_t                m_id;
+
+    // Number of exiting threads returning a cache to this resource, which
+    // must not be destroyed before it is zero.  Guarded by `registry_mutex()`.
+    size_t                  m_releases = 0;
+    std::condition_variable m_released;
+
+    mutable std::mutex                         m_mutex;  // Guards the below
+    std::vector<std::unique_ptr<thread_cache>> m_caches;
+    std::vector<thread_cache*>                 m_unused_caches;
+
+    std::mutex m_upstream_mutex;  // Serializes calls to `m_upstream_p`
+
+    static std::mutex& registry_mutex();
+    static std::unordered_map<uint64_t, thread_caching_resource*>& live();
+    static thread_registry& this_thread_registry();
+
+    thread_cache& local_cache();
+    thread_cache *find_local_cache() const;
+    void release_cache(thread_cache *cache);
+
+    // Return the index of the free list for `bytes` and `*alignment`, or -1
+    // if the request is not cached.  Otherwise, set `*block_size` to the size
+    // class and `*alignment` to the alignment of the blocks in the list.
+    int list_index(size_t bytes, size_t *alignment, size_t *block_size) const;
+
+    void refill(thread_cache& cache, free_list& list, size_t block_size,
+                size_t alignment);
+    void drain(thread_cache& cache, free_list& list, size_t count,
+               size_t block_size, size_t alignment);
+    void drain_all(thread_cache& cache);
+
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const memory_resource& other) const noexcept override;
+};
+
+END_NAMESPACE_XPMR
+
+///////////////////////////////////////////////////////////////////////////////
+// INLINE AND TEMPLATE FUNCTION IMPLEMENTATIONS
+///////////////////////////////////////////////////////////////////////////////
+
+inline std::mutex& XPMR::thread_caching_resource::registry_mutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+inline std::unordered_map<uint64_t, XPMR::thread_caching_resource*>&
+XPMR::thread_caching_resource::live()
+{
+    static std::unordered_map<uint64_t, thread_caching_resource*> resources;
+    return resources;
+}
+
+inline XPMR::thread_caching_resource::thread_registry&
+XPMR::thread_caching_resource::this_thread_registry()
+{
+    thread_local thread_registry registry;
+    return registry;
+}
+
+inline XPMR::thread_caching_resource::thread_registry::~thread_registry()
+{
+    // Draining a cache may add entries for upstream resources, so repeat
+    // until there are none.
+    std::vector<std::pair<thread_caching_resource*, thread_cache*>> pending;
+    while (! m_entries.empty()) {
+        pending.clear();
+        {
+            std::lock_guard<std::mutex> guard(registry_mutex());
+            for (auto [id, cache] : m_entries) {
+                auto it = live().find(id);
+                if (it != live().end()) {
+                    ++it->second->m_releases;
+                    pending.emplace_back(it->second, cache);
+                }
+            }
+            m_entries.clear();
+            m_last_id = ~uint64_t(0);
+        }
+
+        for (auto [resource, cache] : pending) {
+            resource->release_cache(cache);
+            std::lock_guard<std::mutex> guard(registry_mutex());
+            if (0 == --resource->m_releases)
+                resource->m_released.notify_all();
+        }
+    }
+}
+
+inline XPMR::thread_caching_resource::thread_caching_resource(
+    memory_resource *upstream, const thread_caching_options& options)
+    : m_upstream_p(upstream)
+    , m_options(options)
+{
+    static std::atomic<uint64_t> next_id{0};
+
+    if (m_options.max_block_size < min_block_size)
+        m_options.max_block_size = min_block_size;
+    if (m_options.batch_size < 1)
+        m_options.batch_size = 1;
+    if (m_options.max_cached_blocks < m_options.batch_size)
+        m_options.max_cached_blocks = m_options.batch_size;
+
+    m_options.max_block_size = std::bit_ceil(m_options.max_block_size);
+    m_num_size_classes = (std::bit_width(m_options.max_block_size) -
+                          std::bit_width(min_block_size) + 1);
+    m_id = next_id.fetch_add(1, memory_order_relaxed);
+
+    std::lock_guard<std::mutex> guard(registry_mutex());
+    live().emplace(m_id, this);
+}
+
+inline XPMR::thread_caching_resource::~thread_caching_resource()
+{
+    {
+        // After this, exiting threads no longer return their caches here;
+        // wait for those that already are.
+        std::unique_lock<std::mutex> lock(registry_mutex());
+        live().erase(m_id);
+        m_released.wait(lock, [this] { return 0 == m_releases; });
+    }
+
+    for (auto& cache : m_caches) {
+        drain_all(*cache);
+    }
+}
+
+inline XPMR::thread_caching_resource::thread_cache *
+XPMR::thread_caching_resource::find_local_cache() const
+{
+    // Most threads use few resources, and the most recently used one is
+    // checked first.
+    thread_registry& registry = this_thread_registry();
+    if (registry.m_last_id == m_id) return registry.m_last_cache;
+
+    for (auto [id, cache] : registry.m_entries) {
+        if (id == m_id) {
+            registry.m_last_id    = id;
+            registry.m_last_cache = cache;
+            return cache;
+        }
+    }
+    return nullptr;
+}
+
+inline XPMR::thread_caching_resource::thread_cache&
+XPMR::thread_caching_resource::local_cache()
+{
+    if (thread_cache *cache = find_local_cache()) return *cache;
+
+    thread_cache *cache;
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        if (! m_unused_caches.empty()) {
+            cache = m_unused_caches.back();
+            m_unused_caches.pop_back();
+        }
+        else {
+            m_caches.push_back(
+                std::make_unique<thread_cache>(num_align_classes *
+                                               m_num_size_classes));
+            cache = m_caches.back().get();
+        }
+    }
+
+    thread_registry& registry = this_thread_registry();
+    {
+        // Drop the entries of destroyed resources, so that a thread that
+        // uses many short-lived resources does not accumulate them.
+        std::lock_guard<std::mutex> guard(registry_mutex());
+        std::erase_if(registry.m_entries, [](const auto& entry) {
+            return ! live().contains(entry.first);
+        });
+    }
+    registry.m_entries.emplace_back(m_id, cache);
+    return *find_local_cache();
+}
+
+inline void XPMR::thread_caching_resource::release_cache(thread_cache *cache)
+{
+    // Called on thread exit.  The counters are kept, so that the statistics
+    // still include the exited thread.
+    drain_all(*cache);
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_unused_caches.push_back(cache);
+}
+
+inline int XPMR::thread_caching_resource::
+list_index(size_t bytes, size_t *alignment, size_t *block_size) const
+{
+    if (bytes > m_options.max_block_size || *alignment > max_cache_align)
+        return -1;
+
+    if (*alignment < min_block_align) *alignment = min_block_align;
+    *block_size = std::bit_ceil(bytes < min_block_size ?
+                                min_block_size : bytes);
+    if (*block_size < *alignment) *block_size = *alignment;
+
+    const int size_class  = (std::bit_width(*block_size) -
+                             std::bit_width(min_block_size));
+    const int align_class = (std::bit_width(*alignment) -
+                             std::bit_width(min_block_align));
+    return size_class * num_align_classes + align_class;
+}
+
+inline void XPMR::thread_caching_resource::
+refill(thread_cache& cache, free_list& list, size_t block_size,
+       size_t alignment)
+{
+    // The counters are updated for each block, so that they stay accurate
+    // if the upstream resource throws partway through the batch.
+    std::lock_guard<std::mutex> guard(m_upstream_mutex);
+    for (size_t i = 0; i < m_options.batch_size; ++i) {
+        void *block = m_upstream_p->allocate(block_size, alignment);
+        *static_cast<void**>(block) = list.m_head;
+        list.m_head = block;
+        ++list.m_count;
+        ++cache.m_upstream_allocations;
+        ++cache.m_cached_blocks;
+        cache.m_cached_bytes += block_size;
+    }
+}
+
+inline void XPMR::thread_caching_resource::
+drain(thread_cache& cache, free_list& list, size_t count, size_t block_size,
+      size_t alignment)
+{
+    if (count > list.m_count) count = list.m_count;
+
+    std::lock_guard<std::mutex> guard(m_upstream_mutex);
+    for (size_t i = 0; i < count; ++i) {
+        void *block = list.m_head;
+        list.m_head = *static_cast<void**>(block);
+        --list.m_count;
+        m_upstream_p->deallocate(block, block_size, alignment);
+    }
+    cache.m_upstream_deallocations += count;
+    cache.m_cached_blocks          -= count;
+    cache.m_cached_bytes           -= count * block_size;
+}
+
+inline void XPMR::thread_caching_resource::drain_all(thread_cache& cache)
+{
+    for (int size_class = 0; size_class < m_num_size_classes; ++size_class) {
+        for (int align_class = 0; align_class < num_align_classes;
+             ++align_class) {
+            free_list& list =
+                cache.m_lists[size_class * num_align_classes + align_class];
+            if (list.m_count)
+                drain(cache, list, list.m_count,
+                      min_block_size << size_class,
+                      min_block_align << align_class);
+        }
+    }
+}
+
+inline void XPMR::thread_caching_resource::trim()
+{
+    if (thread_cache *cache = find_local_cache()) drain_all(*cache);
+}
+
+inline XPMR::thread_caching_statistics
+XPMR::thread_caching_resource::statistics() const
+{
+    thread_caching_statistics result{};
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    for (const auto& cache : m_caches) {
+        result.hits                   += cache->m_hits.load();
+        result.misses                 += cache->m_misses.load();
+        result.bypasses               += cache->m_bypasses.load();
+        result.upstream_allocations   += cache->m_upstream_allocations.load();
+        result.upstream_deallocations += cache->m_upstream_deallocations.load();
+        result.cached_blocks          += cache->m_cached_blocks.load();
+        result.cached_bytes           += cache->m_cached_bytes.load();
+    }
+
+    return result;
+}
+
+inline void XPMR::thread_caching_resource::reset_statistics()
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    for (const auto& cache : m_caches) {
+        cache->m_hits.reset();
+        cache->m_misses.reset();
+        cache->m_bypasses.reset();
+        cache->m_upstream_allocations.reset();
+        cache->m_upstream_deallocations.reset();
+    }
+}
+
+inline void *XPMR::thread_caching_resource::
+do_allocate(size_t bytes, size_t alignment)
+{
+    thread_cache& cache = local_cache();
+
+    size_t block_size;
+    int    index = list_index(bytes, &alignment, &block_size);
+    if (index < 0) {
+        ++cache.m_bypasses;
+        std::lock_guard<std::mutex> guard(m_upstream_mutex);
+        return m_upstream_p->allocate(bytes, alignment);
+    }
+
+    free_list& list = cache.m_lists[index];
+    if (list.m_head) {
+        ++cache.m_hits;
+    }
+    else {
+        ++cache.m_misses;
+        refill(cache, list, block_size, alignment);
+    }
+
+    void *block = list.m_head;
+    list.m_head = *static_cast<void**>(block);
+    --list.m_count;
+    --cache.m_cached_blocks;
+    cache.m_cached_bytes -= block_size;
+    return block;
+}
+
+inline void XPMR::thread_caching_resource::
+do_deallocate(void *p, size_t bytes, size_t alignment)
+{
+    size_t block_size;
+    int    index = list_index(bytes, &alignment, &block_size);
+    if (index < 0) {
+        std::lock_guard<std::mutex> guard(m_upstream_mutex);
+        m_upstream_p->deallocate(p, bytes, alignment);
+        return;                                                       // RETURN
+    }
+
+    thread_cache& cache = local_cache();
+    free_list&    list  = cache.m_lists[index];
+    *static_cast<void**>(p) = list.m_head;
+    list.m_head = p;
+    ++list.m_count;
+    ++cache.m_cached_blocks;
+    cache.m_cached_bytes += block_size;
+
+    if (list.m_count > m_options.max_cached_blocks)
+        drain(cache, list, m_options.batch_size, block_size, alignment);
+}
+
+inline bool XPMR::thread_caching_resource::
+do_is_equal(const memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+#endif // ! defined(INCLUDED_THREAD_CACHING_RESOURCE_DOT_H)
@@ -0,0 +1,328 @@
+// thread_caching_resource.t.cpp                                      -*-C++-*-
+
+#define RA_SWITCH 1
+
+#include "thread_caching_resource.h"
+#include <resource_adaptor.h>
+
+#include <iostream>
+#include <list>
+#include <thread>
+#include <vector>
+
+//==========================================================================
+//                  ASSERT TEST MACRO
+//--------------------------------------------------------------------------
+static int testStatus = 0;
+
+static void aSsErT(int c, const char *s, int i) {
+    if (c) {
+        std::cout << __FILE__ << ":" << i << ": error: " << s
+                  << "    (failed)" << std::endl;
+        if (testStatus >= 0 && testStatus <= 100) ++testStatus;
+    }
+}
+
+# define TEST_ASSERT(X) { aSsErT(!(X), #X, __LINE__); }
+
+//=============================================================================
+//                  CLASSES FOR TESTING
+//-----------------------------------------------------------------------------
+
+// Memory resource that counts the blocks and bytes outstanding and checks
+// that each block is deallocated with the size and alignment with which it
+// was allocated.  It is not thread-safe, which `thread_caching_resource`
+// must accommodate.
+class TestResource : public std::pmr::memory_resource
+{
+    struct Header
+    {
+        std::size_t d_bytes;
+        std::size_t d_alignment;
+    };
+
+  public:
+    std::size_t d_allocations   = 0;
+    std::size_t d_deallocations = 0;
+    std::size_t d_liveBytes     = 0;
+    std::size_t d_limit         = std::size_t(-1);  // Allocations until throw
+
+  private:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+        if (d_allocations == d_limit) throw std::bad_alloc();
+        ++d_allocations;
+        d_liveBytes += bytes;
+        void *p = std::pmr::new_delete_resource()->allocate(bytes + 64, 64);
+        *static_cast<Header*>(p) = Header{ bytes, alignment };
+        return static_cast<char*>(p) + 64;
+    }
+
+    void do_deallocate(void *p, std::size_t bytes, std::size_t alignment)
+        override {
+        ++d_deallocations;
+        d_liveBytes -= bytes;
+        Header *h = reinterpret_cast<Header*>(static_cast<char*>(p) - 64);
+        TEST_ASSERT(h->d_bytes == bytes);
+        TEST_ASSERT(h->d_alignment == alignment);
+        std::pmr::new_delete_resource()->deallocate(h, bytes + 64, 64);
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+        { return this == &other; }
+};
+
+//=============================================================================
+//                              MAIN PROGRAM
+//-----------------------------------------------------------------------------
+
+int main()
+{
+    using XPMR::thread_caching_resource;
+    using XPMR::thread_caching_options;
+    using XPMR::thread_caching_statistics;
+
+    {
+        // Basic caching and batching
+
+        TestResource upstream;
+        thread_caching_options options;
+        options.max_block_size    = 256;
+        options.batch_size        = 8;
+        options.max_cached_blocks = 16;
+
+        {
+            thread_caching_resource crx(&upstream, options);
+            TEST_ASSERT(crx.upstream_resource() == &upstream);
+
+            // The first allocation refills the list with a batch of blocks.
+            void *p1 = crx.allocate(20, 8);
+            TEST_ASSERT(8 == upstream.d_allocations);
+            TEST_ASSERT(8 * 32 == upstream.d_liveBytes);  // Rounded to 32
+            thread_caching_statistics stats = crx.statistics();
+            TEST_ASSERT(0 == stats.hits);
+            TEST_ASSERT(1 == stats.misses);
+            TEST_ASSERT(7 == stats.cached_blocks);
+            TEST_ASSERT(7 * 32 == stats.cached_bytes);
+
+            // Same size class and alignment: served from the cache
+            void *p2 = crx.allocate(32, 8);
+            TEST_ASSERT(p2 != p1);
+            TEST_ASSERT(8 == upstream.d_allocations);
+            TEST_ASSERT(1 == crx.statistics().hits);
+
+            // Different alignment: a different list
+            void *p3 = crx.allocate(32, 16);
+            TEST_ASSERT(0 == reinterpret_cast<std::uintptr_t>(p3) % 16);
+            TEST_ASSERT(16 == upstream.d_allocations);
+
+            // Deallocated blocks are reused, last in first out.
+            crx.deallocate(p2, 32, 8);
+            TEST_ASSERT(crx.allocate(25, 8) == p2);
+
+            // Too large or too aligned: bypasses the cache
+            void *big = crx.allocate(257, 8);
+            TEST_ASSERT(17 == upstream.d_allocations);
+            void *aligned = crx.allocate(8, 2 * alignof(std::max_align_t));
+            TEST_ASSERT(18 == upstream.d_allocations);
+            TEST_ASSERT(2 == crx.statistics().bypasses);
+            crx.deallocate(big, 257, 8);
+            crx.deallocate(aligned, 8, 2 * alignof(std::max_align_t));
+            TEST_ASSERT(2 == upstream.d_deallocations);
+
+            crx.deallocate(p1, 20, 8);
+            crx.deallocate(p2, 32, 8);
+            crx.deallocate(p3, 32, 16);
+            TEST_ASSERT(2 == upstream.d_deallocations);
+
+            // `trim` returns everything cached by this thread.
+            crx.trim();
+            TEST_ASSERT(18 == upstream.d_deallocations);
+            TEST_ASSERT(0 == upstream.d_liveBytes);
+            stats = crx.statistics();
+            TEST_ASSERT(0 == stats.cached_blocks);
+            TEST_ASSERT(0 == stats.cached_bytes);
+            TEST_ASSERT(16 == stats.upstream_deallocations);
+
+            crx.reset_statistics();
+            stats = crx.statistics();
+            TEST_ASSERT(0 == stats.hits);
+            TEST_ASSERT(0 == stats.misses);
+            TEST_ASSERT(0 == stats.upstream_allocations);
+        }
+        TEST_ASSERT(0 == upstream.d_liveBytes);
+    }
+
+    {
+        // Bound on the number of cached blocks
+
+        TestResource upstream;
+        thread_caching_options options;
+        options.batch_size        = 4;
+        options.max_cached_blocks = 10;
+
+        thread_caching_resource crx(&upstream, options);
+
+        std::vector<void*> blocks;
+        for (int i = 0; i < 40; ++i) {
+            blocks.push_back(crx.allocate(64, 8));
+        }
+        TEST_ASSERT(40 == upstream.d_allocations);
+        for (void *p : blocks) {
+            crx.deallocate(p, 64, 8);
+            TEST_ASSERT(crx.statistics().cached_blocks <= 10);
+        }
+        TEST_ASSERT(upstream.d_deallocations >= 30);
+    }
+
+    {
+        // An upstream failure partway through a refill: the blocks obtained
+        // are cached and counted, and are returned on `trim`.
+
+        TestResource upstream;
+        thread_caching_options options;
+        options.batch_size = 8;
+        thread_caching_resource crx(&upstream, options);
+
+        upstream.d_limit = 5;
+        bool caught = false;
+        try {
+            (void) crx.allocate(64, 8);
+        }
+        catch (const std::bad_alloc&) {
+            caught = true;
+        }
+        TEST_ASSERT(caught);
+        thread_caching_statistics stats = crx.statistics();
+        TEST_ASSERT(5 == stats.upstream_allocations);
+        TEST_ASSERT(5 == stats.cached_blocks);
+        TEST_ASSERT(5 * 64 == stats.cached_bytes);
+
+        upstream.d_limit = std::size_t(-1);
+        crx.trim();
+        stats = crx.statistics();
+        TEST_ASSERT(5 == stats.upstream_deallocations);
+        TEST_ASSERT(0 == stats.cached_blocks);
+        TEST_ASSERT(0 == stats.cached_bytes);
+        TEST_ASSERT(0 == upstream.d_liveBytes);
+    }
+
+    {
+        // A thread that uses many short-lived resources keeps the cache of a
+        // long-lived one.
+
+        TestResource upstream;
+        thread_caching_resource crx(&upstream);
+        crx.deallocate(crx.allocate(64, 8), 64, 8);
+        for (int i = 0; i < 100; ++i) {
+            thread_caching_resource shortLived(&upstream);
+            shortLived.deallocate(shortLived.allocate(64, 8), 64, 8);
+        }
+        const std::size_t allocations = upstream.d_allocations;
+        crx.deallocate(crx.allocate(64, 8), 64, 8);
+        TEST_ASSERT(allocations == upstream.d_allocations);
+        TEST_ASSERT(1 == crx.statistics().hits);
+    }
+
+    {
+        // Cached blocks are returned on destruction.  Small sizes and
+        // alignments are rounded up to those of a pointer.
+
+        TestResource upstream;
+        {
+            thread_caching_resource crx(&upstream);
+            void *p = crx.allocate(1, 1);
+            TEST_ASSERT(0 == reinterpret_cast<std::uintptr_t>(p) %
+                             alignof(void*));
+            crx.deallocate(p, 1, 1);
+        }
+        TEST_ASSERT(upstream.d_allocations == upstream.d_deallocations);
+    }
+
+    {
+        // Threads, including cross-thread deallocation and return of the
+        // caches of exited threads
+
+        TestResource upstream;
+        thread_caching_resource crx(&upstream);
+
+        std::vector<void*> fromThreads[4];
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&crx, &out = fromThreads[t]] {
+                std::pmr::list<int> lst(&crx);
+                for (int i = 0; i < 1000; ++i) {
+                    lst.push_back(i);
+                    if (i % 3 == 0) lst.pop_front();
+                }
+                for (int i = 0; i < 100; ++i) {
+                    out.push_back(crx.allocate(48, 16));
+                }
+            });
+        }
+        for (std::thread& th : threads) {
+            th.join();
+        }
+
+        // All caches of the exited threads have been returned.
+        TEST_ASSERT(0 == crx.statistics().cached_blocks);
+        TEST_ASSERT(400 * 64 == upstream.d_liveBytes);
+
+        // Deallocate, in this thread, blocks allocated by the other threads.
+        for (auto& out : fromThreads) {
+            for (void *p : out) {
+                crx.deallocate(p, 48, 16);
+            }
+        }
+        crx.trim();
+        TEST_ASSERT(0 == upstream.d_liveBytes);
+        TEST_ASSERT(upstream.d_allocations == upstream.d_deallocations);
+    }
+
+    {
+        // Stacked resources: a thread that only deallocates through the
+        // outer resource returns the caches of both on exit.
+
+        TestResource upstream;
+        thread_caching_resource inner(&upstream);
+        thread_caching_resource outer(&inner);
+
+        std::vector<void*> blocks;
+        for (int i = 0; i < 100; ++i) {
+            blocks.push_back(outer.allocate(64, 8));
+        }
+        std::thread th([&] {
+            for (void *p : blocks) {
+                outer.deallocate(p, 64, 8);
+            }
+        });
+        th.join();
+
+        // Only the main thread's cache of `outer` remains: four batches of
+        // 32 blocks, less the 100 allocated.
+        TEST_ASSERT(28 == outer.statistics().cached_blocks);
+        TEST_ASSERT(0 == inner.statistics().cached_blocks);
+        TEST_ASSERT(28 * 64 == upstream.d_liveBytes);
+        outer.trim();
+        inner.trim();
+        TEST_ASSERT(0 == outer.statistics().cached_blocks);
+        TEST_ASSERT(0 == inner.statistics().cached_blocks);
+        TEST_ASSERT(0 == upstream.d_liveBytes);
+    }
+
+    {
+        // In front of a `resource_adaptor`
+
+        XPMR::resource_adaptor<std::allocator<char>> adaptor;
+        thread_caching_resource crx(&adaptor);
+
+        std::pmr::vector<std::pmr::list<double>> v(&crx);
+        for (int i = 0; i < 100; ++i) {
+            v.emplace_back(10, double(i));
+        }
+        TEST_ASSERT(100 == v.size());
+        TEST_ASSERT(99.0 == v.back().front());
+        TEST_ASSERT(crx.statistics().hits > crx.statistics().misses);
+    }
+
+    return testStatus;
+}
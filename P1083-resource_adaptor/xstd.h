@@ -11,7 +11,11 @@
 #ifndef INCLUDED_XSTD_DOT_H
 #define INCLUDED_XSTD_DOT_H
 
-#define XSTD xstd
+// `XSTD` may be predefined (e.g., `-DXSTD=ra_switch`) so that variants of the
+// same component can be built into one program without violating the ODR.
+#ifndef XSTD
+# define XSTD xstd
+#endif
 #define BEGIN_NAMESPACE_XSTD namespace XSTD {
 #define END_NAMESPACE_XSTD   }
 #define USING_NAMESPACE_XSTD using namespace XSTD
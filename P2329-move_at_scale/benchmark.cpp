@@ -5,21 +5,103 @@
 #include <algorithm>
 #include <memory_resource>
 #include <vector>
+#include <list>
+#include <unordered_map>
 #include <chrono>
+#include <string>
+#include <thread>
+#include <barrier>
+#include <memory>
+#include <optional>
+#include <array>
+#include <bit>
+#include <type_traits>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <ctime>
 
 #include <cstdlib>
 #include <cstring>
+#include <cstdint>
+#include <cmath>
 #include <cassert>
 
+#ifdef __unix__
+# include <sys/resource.h>
+# include <sys/utsname.h>
+#endif
+
+#ifdef __linux__
+# include <sys/mman.h>
+# include <unistd.h>
+# include <cerrno>
+#endif
+
+#include "perf_counters.h"
+#include "latency_histogram.h"
+#include "mmap_resource.h"
+#include "../relocate/relocate.h"
+
 namespace chrono = std::chrono;
 
 constexpr unsigned KiB = 1024;
 constexpr unsigned MiB = 1024 * KiB;
 constexpr unsigned GiB = 1024 * MiB;
 
-using Element   = std::pmr::vector<char>;
-using Subsystem = std::pmr::vector<Element>;
-using System    = std::pmr::vector<Subsystem>;
+constexpr std::size_t cacheLineSize = 64;
+constexpr std::size_t pageSize      = 4 * KiB;
+
+// Element types, selected with the `-e` option.  Each element holds about
+// `elemSize` bytes of payload.
+using Bytes   = std::pmr::vector<char>;  // Default
+using String  = std::pmr::string;
+
+// Trivially copyable record held in a `Samples` element.
+struct Sample
+{
+    std::uint32_t id;
+    float         value;
+    std::uint64_t stamp;
+};
+
+using Samples = std::pmr::vector<Sample>;
+using List    = std::pmr::list<std::uint64_t>;
+using HashMap = std::pmr::unordered_map<std::uint32_t, std::uint32_t>;
+
+// Allocator-aware structure holding several of the above, as a typical
+// "record" type would.
+struct Mixed
+{
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    String  name;
+    Samples samples;
+    List    history;
+
+    explicit Mixed(const allocator_type& a = {})
+        : name(a), samples(a), history(a) { }
+
+    Mixed(const Mixed& other, const allocator_type& a = {})
+        : name(other.name, a)
+        , samples(other.samples, a)
+        , history(other.history, a) { }
+
+    Mixed(Mixed&& other) = default;
+
+    Mixed(Mixed&& other, const allocator_type& a)
+        : name(std::move(other.name), a)
+        , samples(std::move(other.samples), a)
+        , history(std::move(other.history), a) { }
+
+    Mixed& operator=(const Mixed&) = default;
+    Mixed& operator=(Mixed&&) = default;
+
+    allocator_type get_allocator() const { return name.get_allocator(); }
+};
+
+template <class E> using SubsystemOf = std::pmr::vector<E>;
+template <class E> using SystemOf    = std::pmr::vector<SubsystemOf<E>>;
 
 bool verbose      = false;
 bool showProgress = false;
@@ -31,45 +113,409 @@ std::size_t elemSize      ;
 std::size_t churnCount    ;
 std::size_t accessCount   ;
 std::size_t repCount      ;
+std::size_t numThreads = 1;
+
+// Number of discarded warmup runs (`-w` option) and measured repetitions (`-n`
+// option) of each arm.  The arms are interleaved (copy, move, copy, move, ...)
+// so that slow drifts, such as frequency scaling, affect them equally.
+std::size_t warmupCount = 0;
+std::size_t repetitions = 1;
+
+// Memory resource used to allocate the system, selected with the `-r` option.
+enum class ResourceKind {
+    monotonic,   // monotonic_buffer_resource over a fixed buffer (default)
+    growing,     // monotonic_buffer_resource growing from new_delete_resource
+    unsyncPool,  // unsynchronized_pool_resource
+    syncPool,    // synchronized_pool_resource
+    newDelete    // new_delete_resource()
+};
+
+struct ResourceName
+{
+    ResourceKind kind;
+    const char*  name;
+};
+
+constexpr ResourceName resourceNames[] = {
+    { ResourceKind::monotonic,  "mono"   },
+    { ResourceKind::growing,    "grow"   },
+    { ResourceKind::unsyncPool, "unsync" },
+    { ResourceKind::syncPool,   "sync"   },
+    { ResourceKind::newDelete,  "newdel" }
+};
+
+ResourceKind resourceKind = ResourceKind::monotonic;
+
+// Type of each element, selected with the `-e` option.
+enum class ElementKind {
+    bytes,    // `Bytes` (default)
+    string,   // `String`
+    samples,  // `Samples`
+    list,     // `List`
+    hashMap,  // `HashMap`
+    mixed     // `Mixed`
+};
+
+struct ElementName
+{
+    ElementKind kind;
+    const char* name;
+};
+
+constexpr ElementName elementNames[] = {
+    { ElementKind::bytes,   "bytes"   },
+    { ElementKind::string,  "string"  },
+    { ElementKind::samples, "structs" },
+    { ElementKind::list,    "list"    },
+    { ElementKind::hashMap, "umap"    },
+    { ElementKind::mixed,   "mixed"   }
+};
+
+ElementKind elementKind = ElementKind::bytes;
+
+// How the buffer for the default `mono` resource is obtained, selected with
+// the `-m` option as a `+`-separated list of the following flags.  With no
+// flags, the buffer is obtained from `::operator new`.  These options separate
+// the cost of page faults and TLB misses from the cache-locality effects being
+// measured.
+enum BufferFlags {
+    bufMmap     = 1,  // Anonymous `mmap` region
+    bufHugePage = 2,  // `mmap` + `madvise(MADV_HUGEPAGE)` (transparent huge
+                      // pages)
+    bufPopulate = 4,  // `mmap` with all pages faulted in up front
+    bufTouch    = 8   // Write one byte per page before running any test
+};
+
+struct BufferFlagName
+{
+    int         flag;
+    const char* name;
+};
+
+constexpr BufferFlagName bufferFlagNames[] = {
+    { bufMmap,     "mmap"     },
+    { bufHugePage, "thp"      },
+    { bufPopulate, "populate" },
+    { bufTouch,    "touch"    }
+};
+
+int bufferFlags = 0;
+
+// Kernel used by `accessSubsystem` to read each element, selected with the
+// `-k` option.  Both kernels compute the same result.
+enum class AccessKernel {
+    scalar,  // One `char` per iteration (the original kernel, default)
+    vector   // One vector register per iteration
+};
+
+AccessKernel accessKernel = AccessKernel::scalar;
+
+// If true (`-d` option), also run the test using destructive move
+// (relocation) in addition to copy and move assignment.
+bool runRelocate = false;
+
+// If true (`-l` option), measure the locality of each subsystem after the
+// last churn of a run.
+bool analyzeLocality = false;
+
+// Pattern in which `churn` moves elements between subsystems, selected with
+// the `-s` option.
+enum class ChurnPattern {
+    uniform,   // Rotate each rank through all subsystems in random order
+    zipf,      // Rotate each rank through a Zipf-distributed set of subsystems
+    neighbor,  // Shift each rank by one subsystem
+    batch      // Swap runs of consecutive elements between two subsystems
+};
+
+ChurnPattern churnPattern = ChurnPattern::uniform;
+double       zipfSkew     = 1.0;  // Exponent for `ChurnPattern::zipf`
+std::size_t  batchSize    = 16;   // Run length for `ChurnPattern::batch`
+
+// If nonzero (`-z` option), compact the system after every `compactInterval`
+// churns by copying it into a fresh memory resource and releasing the old one.
+std::size_t compactInterval = 0;
+
+// If true (`-h` option), record the latency of each call to `churn` and to
+// `accessSubsystem` in a histogram.
+bool recordLatency = false;
+
+// If true (`-f` option), measure the memory footprint of each arm: the bytes
+// consumed from the system's memory resource, the allocations made from the
+// default resource during churn, and the peak resident set size.  This is
+// done in an additional, untimed run of each arm, so that the instrumentation
+// does not affect the times.
+bool measureFootprint = false;
+
+// True during that untimed run, when the footprint is recorded.
+bool footprintPass = false;
+
+// If true (`-c` option), count hardware events in each phase of a run.
+bool countEvents = false;
+bool eventAvailable[numPerfEvents];  // Set by `main` if `countEvents`
+
+// Format of the results printed to standard output (`-o` option).  The `text`
+// format is the original three-line format read by `runtest`; the `csv` and
+// `json` formats print a single record containing every parameter, the
+// per-phase timings, and a description of the environment.
+enum class OutputFormat { text, csv, json };
+
+OutputFormat outputFormat = OutputFormat::text;
+
+// Vector of `char` processed in one iteration of the `vector` access kernel.
+// With GCC or Clang, this is a vector register as wide as the target allows
+// (e.g., compile with `OPT="-O3 -march=native"` to use AVX2 or AVX-512);
+// otherwise it is a 64-bit word.
+#if defined(__GNUC__)
+# if defined(__AVX512BW__)
+constexpr std::size_t vecBytes = 64;
+# elif defined(__AVX2__)
+constexpr std::size_t vecBytes = 32;
+# else
+constexpr std::size_t vecBytes = 16;
+# endif
+typedef char VecChars __attribute__((vector_size(vecBytes)));
+#else
+constexpr std::size_t vecBytes = sizeof(std::uint64_t);
+using VecChars = std::uint64_t;
+#endif
+
+inline char xorBytesScalar(const char* p, std::size_t len)
+    // Return the XOR of the `len` bytes at `p`.
+{
+    char x = 0;
+    for (std::size_t i = 0; i < len; ++i) {
+        x ^= p[i];
+    }
+    return x;
+}
+
+inline char xorBytesVector(const char* p, std::size_t len)
+    // Return the XOR of the `len` bytes at `p`, processing `vecBytes` bytes
+    // per iteration.
+{
+    VecChars    acc{};
+    std::size_t i = 0;
+    for (; i + vecBytes <= len; i += vecBytes) {
+        VecChars v;
+        std::memcpy(&v, p + i, vecBytes);  // Elements need not be aligned
+        acc ^= v;
+    }
+
+    // Fold the lanes of `acc` together, then the remaining bytes.
+    char lanes[vecBytes];
+    std::memcpy(lanes, &acc, vecBytes);
+    char x = 0;
+    for (char c : lanes) {
+        x ^= c;
+    }
+    for (; i < len; ++i) {
+        x ^= p[i];
+    }
+    return x;
+}
+
+inline char xorBytes(const char* p, std::size_t len)
+    // Return the XOR of the `len` bytes at `p`, using the kernel selected by
+    // `accessKernel`.
+{
+    return (AccessKernel::vector == accessKernel ?
+            xorBytesVector(p, len) : xorBytesScalar(p, len));
+}
+
+// Operations on each element type `E`:
+// * `init(E* e, std::size_t bytes, char c)` fills the empty element `*e` with
+//   about `bytes` bytes of payload derived from `c`.
+// * `access(E* e)` reads every part of `*e`, then modifies one part.
+// * `forEachBlock(const E& e, f)` calls `f(address, size)` for each
+//   separately allocated part of `e` (used by `measureLocality`).
+template <class E>
+struct ElementOps;
+
+template <>
+struct ElementOps<Bytes>
+{
+    static void init(Bytes* e, std::size_t bytes, char c) {
+        e->reserve(bytes);
+        e->insert(e->begin(), bytes, c);
+    }
+
+    static void access(Bytes* e) {
+        // XOR last 3 bits of each byte of element into first byte
+        char x = xorBytes(e->data(), e->size());
+        (*e)[0] ^= (x & 7);
+    }
+
+    template <class F>
+    static void forEachBlock(const Bytes& e, F f)
+        { if (! e.empty()) f(e.data(), e.size()); }
+};
+
+template <>
+struct ElementOps<String>
+{
+    static void init(String* e, std::size_t bytes, char c)
+        { e->assign(bytes, c); }
+
+    static void access(String* e) {
+        char x = xorBytes(e->data(), e->size());
+        (*e)[0] ^= (x & 7);
+    }
+
+    template <class F>
+    static void forEachBlock(const String& e, F f)
+        { if (! e.empty()) f(e.data(), e.size()); }
+};
+
+template <>
+struct ElementOps<Samples>
+{
+    static void init(Samples* e, std::size_t bytes, char c) {
+        std::size_t n = std::max(bytes / sizeof(Sample), std::size_t(1));
+        e->reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            e->push_back(Sample{ std::uint32_t(i), float(c),
+                                 std::uint64_t(c) * i });
+        }
+    }
+
+    static void access(Samples* e) {
+        std::uint64_t x = 0;
+        for (const Sample& smp : *e) {
+            x ^= smp.id ^ std::bit_cast<std::uint32_t>(smp.value) ^ smp.stamp;
+        }
+        e->front().stamp ^= (x & 7);
+    }
+
+    template <class F>
+    static void forEachBlock(const Samples& e, F f)
+        { f(e.data(), e.size() * sizeof(Sample)); }
+};
+
+template <>
+struct ElementOps<List>
+{
+    static void init(List* e, std::size_t bytes, char c) {
+        std::size_t n =
+            std::max(bytes / sizeof(List::value_type), std::size_t(1));
+        for (std::size_t i = 0; i < n; ++i) {
+            e->push_back(std::uint64_t(c) + i);
+        }
+    }
+
+    static void access(List* e) {
+        std::uint64_t x = 0;
+        for (std::uint64_t v : *e) {
+            x ^= v;
+        }
+        e->front() ^= (x & 7);
+    }
 
-void initializeSubsystem(Subsystem* ss)
-  // Initialize `ss` to `elemsPerSubsys` elements of `elemSize` length.
+    template <class F>
+    static void forEachBlock(const List& e, F f) {
+        for (const std::uint64_t& v : e) {
+            f(&v, sizeof(v));
+        }
+    }
+};
+
+template <>
+struct ElementOps<HashMap>
+{
+    static void init(HashMap* e, std::size_t bytes, char c) {
+        std::size_t n =
+            std::max(bytes / (2 * sizeof(std::uint32_t)), std::size_t(1));
+        e->reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            e->emplace(std::uint32_t(i), std::uint32_t(c) + i);
+        }
+    }
+
+    static void access(HashMap* e) {
+        std::uint32_t x = 0;
+        for (const auto& kv : *e) {
+            x ^= kv.second;
+        }
+        e->begin()->second ^= (x & 7);
+    }
+
+    template <class F>
+    static void forEachBlock(const HashMap& e, F f) {
+        for (const auto& kv : e) {
+            f(&kv, sizeof(kv));
+        }
+    }
+};
+
+template <>
+struct ElementOps<Mixed>
+{
+    // The payload is divided among the members: a quarter in `name`, half in
+    // `samples`, and the rest in `history`.
+    static void init(Mixed* e, std::size_t bytes, char c) {
+        ElementOps<String>::init(&e->name, bytes / 4, c);
+        ElementOps<Samples>::init(&e->samples, bytes / 2, c);
+        ElementOps<List>::init(&e->history, bytes - bytes / 4 - bytes / 2, c);
+    }
+
+    static void access(Mixed* e) {
+        ElementOps<String>::access(&e->name);
+        ElementOps<Samples>::access(&e->samples);
+        ElementOps<List>::access(&e->history);
+    }
+
+    template <class F>
+    static void forEachBlock(const Mixed& e, F f) {
+        ElementOps<String>::forEachBlock(e.name, f);
+        ElementOps<Samples>::forEachBlock(e.samples, f);
+        ElementOps<List>::forEachBlock(e.history, f);
+    }
+};
+
+template <class E>
+void initializeSubsystem(SubsystemOf<E>* ss)
+  // Initialize `ss` to `elemsPerSubsys` elements of about `elemSize` bytes.
 {
     ss->reserve(elemsPerSubsys);
     for (std::size_t i = 0; i < elemsPerSubsys; ++i) {
         char c = 'A' + (std::rand() & 31);
-        Element& e = ss->emplace_back();
-        e.reserve(elemSize);
-        e.insert(e.begin(), elemSize, c);
-        // ss->emplace_back(elemSize, c);
+        E& e = ss->emplace_back();
+        ElementOps<E>::init(&e, elemSize, c);
     }
 }
 
-void accessSubsystem(Subsystem* ss, std::size_t accessCount)
+template <class E>
+void accessSubsystem(SubsystemOf<E>* ss, std::size_t accessCount)
     // Ping the subsystem, simulating read/write accesses proportional to the
     // specified `accessCount`.
 {
     if (ss->empty()) return;  // nothing to access
 
     for (std::size_t i = 0; i < accessCount; ++i) {
-        for (Element& e : *ss) {
-            // XOR last 3 bits of each byte of element into first byte
-            char x = 0;
-            for (char c : e) {
-                x ^= c;
-            }
-            e[0] ^= (x & 7);
+        for (E& e : *ss) {
+            ElementOps<E>::access(&e);
         }
     }
 }
 
+// The way in which `churn` moves elements between subsystems.
+enum class Arm {
+    copy,      // Copy assignment
+    move,      // Move assignment
+    relocate   // Relocation (destructive move) into the vacated slot, using
+               // `xstd::uninitialized_relocate`.  A standard container cannot
+               // opt into trivial relocation, so, for each element type, this
+               // is a move construction immediately followed by destruction
+               // of the source.
+};
+
 template <bool UseCopy>
 struct CopyOrMove_t;
 
 template <>
 struct CopyOrMove_t<true>
 {
-    void operator()(Element *to, const Element& from) const {
+    template <class E>
+    void operator()(E *to, const E& from) const {
         *to = from;
     }
 };
@@ -77,28 +523,154 @@ struct CopyOrMove_t<true>
 template <>
 struct CopyOrMove_t<false>
 {
-    void operator()(Element *to, Element& from) const {
+    template <class E>
+    void operator()(E *to, E& from) const {
         *to = std::move(from);
     }
 };
 
-template <bool UseCopy>
-void churn(System *system, std::size_t churnCount)
+// Index of the calling thread among the threads of a multithreaded (`-t`)
+// run, or 0 in a single-threaded run.
+thread_local std::size_t threadIndex = 0;
+
+template <class Rotate>
+void churnCycles(std::size_t nS,
+                 std::size_t sS,
+                 std::size_t churnCount,
+                 Rotate      rotate)
+    // Perform `churnCount` churns of a system of `nS` subsystems of `sS`
+    // elements each by calling `rotate(cycle, len, e)` for each rotation of
+    // the elements at rank `e` through the `len` distinct subsystems listed in
+    // `cycle`, as selected by `churnPattern`.  Each instantiation (i.e., each
+    // arm and element type) has its own random state, so that every arm
+    // performs the same sequence of rotations.
 {
     using std::size_t;
 
-    static std::mt19937 rengine;
-    static std::uniform_int_distribution<size_t> urand(0, system->size()-1);
-
-    const size_t nS = system->size();
-    const size_t sS = (*system)[0].size(); // Subsystem size
+    // Each thread churns only its own partition of the system, so the random
+    // state is per-thread.  It is seeded from the thread index, so that the
+    // threads do not churn in lockstep but each thread of each arm performs
+    // the same sequence of rotations.
+    thread_local std::mt19937 rengine(
+        std::mt19937::default_seed + std::mt19937::result_type(threadIndex));
+    thread_local std::uniform_int_distribution<size_t> urand(0, nS-1);
 
     // Vector of indexes used to shuffle elements between subsystems
-    static std::vector<size_t> randomSeq(nS);
+    thread_local std::vector<size_t> randomSeq(nS);
     for (size_t i = 0; i < nS; ++i) {
         randomSeq[i] = i;
     }
 
+    switch (churnPattern) {
+      case ChurnPattern::uniform: {
+        // Rotate values randomly through all 'nS' elements at each rank.
+        for (size_t c = 0; c < churnCount; ++c) {
+            for (size_t e = 0; e < sS; ++e) {
+                std::shuffle(randomSeq.begin(), randomSeq.end(), rengine);
+                rotate(randomSeq.data(), nS, e);
+            }
+        }
+      } break;
+
+      case ChurnPattern::zipf: {
+        // Draw `nS` subsystems from a Zipf distribution in which subsystem
+        // `k` has weight `1 / (k+1)^zipfSkew` and rotate through the distinct
+        // subsystems drawn.  Low-numbered subsystems are nearly always
+        // included; high-numbered ones rarely are.
+        std::vector<double> weights(nS);
+        for (size_t k = 0; k < nS; ++k) {
+            weights[k] = 1.0 / std::pow(double(k + 1), zipfSkew);
+        }
+        std::discrete_distribution<size_t> zipf(weights.begin(),
+                                                weights.end());
+        std::vector<size_t> cycle;
+        std::vector<char>   inCycle(nS, false);
+        cycle.reserve(nS);
+        for (size_t c = 0; c < churnCount; ++c) {
+            for (size_t e = 0; e < sS; ++e) {
+                cycle.clear();
+                for (size_t i = 0; i < nS; ++i) {
+                    size_t k = zipf(rengine);
+                    if (! inCycle[k]) {
+                        inCycle[k] = true;
+                        cycle.push_back(k);
+                    }
+                }
+                for (size_t k : cycle) {
+                    inCycle[k] = false;
+                }
+                rotate(cycle.data(), cycle.size(), e);
+            }
+        }
+      } break;
+
+      case ChurnPattern::neighbor: {
+        // Shift the elements at each rank by one subsystem, in a random
+        // direction, so that each element moves only to a neighboring
+        // subsystem.
+        std::vector<size_t> backward(randomSeq.rbegin(), randomSeq.rend());
+        for (size_t c = 0; c < churnCount; ++c) {
+            for (size_t e = 0; e < sS; ++e) {
+                const size_t* cycle =
+                    (rengine() & 1) ? backward.data() : randomSeq.data();
+                rotate(cycle, nS, e);
+            }
+        }
+      } break;
+
+      case ChurnPattern::batch: {
+        // Swap runs of `batchSize` consecutive elements between two randomly
+        // chosen subsystems, moving about as many elements in total as the
+        // other patterns.
+        const size_t runLength  = std::min(batchSize, sS);
+        const size_t numBatches =
+            std::max(nS * sS / (2 * runLength), size_t(1));
+        std::uniform_int_distribution<size_t> rankRand(0, sS - 1);
+        for (size_t c = 0; c < churnCount; ++c) {
+            for (size_t b = 0; b < numBatches; ++b) {
+                size_t pair[2] = { urand(rengine), 0 };
+                do {
+                    pair[1] = urand(rengine);
+                } while (nS > 1 && pair[1] == pair[0]);
+                const size_t first = rankRand(rengine);
+                for (size_t i = 0; i < runLength; ++i) {
+                    rotate(pair, nS > 1 ? 2 : 1, (first + i) % sS);
+                }
+            }
+        }
+      } break;
+    }
+}
+
+template <Arm A, class E>
+void churn(SystemOf<E> *system, std::size_t churnCount)
+{
+    using std::size_t;
+
+    const size_t nS = system->size();
+    const size_t sS = (*system)[0].size(); // Subsystem size
+
+    if constexpr (Arm::relocate == A) {
+        // Relocate each element into the slot vacated by the previous one,
+        // leaving no moved-from element behind.  Between relocations, exactly
+        // one slot (initially `temp`) holds no live element.
+        alignas(E) unsigned char temp[sizeof(E)];
+        E *const tempElem = reinterpret_cast<E*>(temp);
+
+        churnCycles(nS, sS, churnCount,
+                    [&](const size_t* cycle, size_t len, size_t e) {
+            E *hole = tempElem;
+            for (size_t i = 0; i < len; ++i) {
+                E *fromElem = &(*system)[cycle[i]][e];
+                xstd::uninitialized_relocate(fromElem, hole);
+                hole = fromElem;
+            }
+            xstd::uninitialized_relocate(tempElem, hole);
+        });
+        return;
+    }
+
+    constexpr bool UseCopy = (Arm::copy == A);
     static constexpr CopyOrMove_t<UseCopy> copyOrMove{};
 
     // When using copy assignment, use the global allocator for the temporary
@@ -109,25 +681,23 @@ void churn(System *system, std::size_t churnCount)
     std::pmr::polymorphic_allocator<char> tempAlloc = UseCopy ?
         std::pmr::get_default_resource() : system->get_allocator();
 
-    Element tempElem(tempAlloc);
-
-    // Repeat shuffle 'churnCount' times (default 1)
-    for (size_t c = 0; c < churnCount; ++c) {
-        for (size_t e = 0; e < sS; ++e) {
-            // Rotate values randomly through 'nS' elements at rank 'e'
-            std::shuffle(randomSeq.begin(), randomSeq.end(), rengine);
-            Element *hole = &tempElem;
-            for (auto k : randomSeq) {
-                Element &fromElem = (*system)[k][e];
-                copyOrMove(hole, fromElem);
-                hole = &fromElem;
-            }
-            // Finish rotation
-            copyOrMove(hole, tempElem);
+    E tempElem(tempAlloc);
+
+    // Repeat churn 'churnCount' times (default 1)
+    churnCycles(nS, sS, churnCount,
+                [&](const size_t* cycle, size_t len, size_t e) {
+        E *hole = &tempElem;
+        for (size_t i = 0; i < len; ++i) {
+            E &fromElem = (*system)[cycle[i]][e];
+            copyOrMove(hole, fromElem);
+            hole = &fromElem;
         }
-    }
+        // Finish rotation
+        copyOrMove(hole, tempElem);
+    });
 }
 
+
 template <typename TP>
 void progress(const char* label, TP& snapShot, std::size_t rep,
               std::size_t ss, const char* msg)
@@ -145,49 +715,936 @@ void progress(const char* label, TP& snapShot, std::size_t rep,
     }
 }
 
-template <bool UseCopy>
-chrono::milliseconds doTest(void* buffer, std::size_t totalBytes)
+// Description of the portion of the system owned by a single thread: the
+// buffer from which it allocates and the number of subsystems it holds.  When
+// running single-threaded, there is exactly one partition holding the entire
+// system.  When compacting, the system alternates between `buffer` and
+// `spareBuffer`, which are the same size.
+struct Partition
 {
-    static constexpr const char* label = UseCopy ? "[copy]" : "[move]";
+    void*       buffer;
+    void*       spareBuffer;
+    std::size_t bufferBytes;
+    std::size_t numSubsystems;
+};
 
-    auto startInit = chrono::steady_clock::now();
-    auto snapShot  = startInit;
+// Start and stop times of the timed section of a run.
+struct Interval
+{
+    chrono::steady_clock::time_point start;
+    chrono::steady_clock::time_point stop;
+
+    chrono::milliseconds elapsed() const
+        { return chrono::duration_cast<chrono::milliseconds>(stop - start); }
+};
 
-    std::pmr::monotonic_buffer_resource rsrc(buffer, totalBytes,
-                                             std::pmr::null_memory_resource());
+// Phases of a run for which hardware events are counted separately.
+enum Phase { initPhase, churnPhase, accessPhase, compactPhase, numPhases };
 
-    System system(numSubsystems, &rsrc);
+const char* const phaseNames[numPhases] = {
+    "init", "churn", "access", "compact"
+};
+
+bool phaseReported(int ph)
+    // Return true if results for the specified phase are reported.  The
+    // compaction phase is reported only when compacting.
+{
+    return compactPhase != ph || compactInterval > 0;
+}
+
+using PhaseTimes  = std::array<chrono::nanoseconds, numPhases>;
+using PhaseEvents = std::array<PerfCounters::Values, numPhases>;
+
+// Quantiles of the latency histograms that are reported.
+struct Quantile
+{
+    double      fraction;
+    const char* name;
+};
+
+constexpr Quantile latencyQuantiles[] = {
+    { 0.5,   "p50"  },
+    { 0.99,  "p99"  },
+    { 0.999, "p999" }
+};
+
+// Buckets of the histogram of the distance of each element's buffer from the
+// median buffer address of its subsystem.  Each bucket but the last is
+// bounded (exclusively) by the corresponding entry of `distanceBounds`.
+constexpr std::size_t distanceBounds[] = {
+    cacheLineSize, pageSize, 256 * KiB, 16 * MiB
+};
+
+constexpr int numDistanceBuckets = std::size(distanceBounds) + 1;
+
+const char* const distanceBucketNames[numDistanceBuckets] = {
+    "lt64B", "lt4K", "lt256K", "lt16M", "ge16M"
+};
+
+// How spread out the element buffers of a set of subsystems are across
+// memory, summed over the subsystems.  A subsystem whose elements are packed
+// together has all of its elements in the first buckets of `histogram` and
+// touches few distinct cache lines and pages.
+struct Locality
+{
+    std::array<std::uint64_t, numDistanceBuckets> histogram;
+    std::uint64_t cacheLines;  // Distinct cache lines touched by the elements
+    std::uint64_t pages;       // Distinct pages touched by the elements
+
+    Locality& operator+=(const Locality& rhs) {
+        for (int b = 0; b < numDistanceBuckets; ++b) {
+            histogram[b] += rhs.histogram[b];
+        }
+        cacheLines += rhs.cacheLines;
+        pages      += rhs.pages;
+        return *this;
+    }
+};
+
+// Memory used by one run.  All zero unless `measureFootprint`.
+struct Footprint
+{
+    std::uint64_t arenaBytes    = 0;  // Consumed from the system's resource
+    std::uint64_t defaultAllocs = 0;  // Default-resource allocations in churn
+    std::uint64_t defaultBytes  = 0;  // Bytes in `defaultAllocs`
+    std::uint64_t peakRssKiB    = 0;  // Peak resident set size of the process
+
+    // Add the usage of `rhs`, which ran concurrently with this one.
+    Footprint& operator+=(const Footprint& rhs) {
+        arenaBytes    += rhs.arenaBytes;
+        defaultAllocs += rhs.defaultAllocs;
+        defaultBytes  += rhs.defaultBytes;
+        peakRssKiB     = std::max(peakRssKiB, rhs.peakRssKiB);
+        return *this;
+    }
+};
+
+void resetPeakRss()
+    // Reset the peak resident set size of the process to its current size,
+    // if the kernel supports it (Linux 4.0 and later), so that `peakRssKiB`
+    // reports the peak of the next run only.
+{
+#ifdef __linux__
+    std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+}
+
+std::uint64_t peakRssKiB()
+    // Return the peak resident set size of the process in KiB, or zero if it
+    // is not available.  On Linux, this is `VmHWM` from `/proc/self/status`,
+    // which `resetPeakRss` resets; `getrusage` is not used there because its
+    // `ru_maxrss` keeps the peaks of exited threads.  Elsewhere, it is
+    // `ru_maxrss`.
+{
+#if defined(__linux__)
+    std::ifstream status("/proc/self/status");
+    std::string   line;
+    while (std::getline(status, line)) {
+        if (0 == line.compare(0, 6, "VmHWM:"))
+            return std::strtoull(line.c_str() + 6, nullptr, 10);
+    }
+    return 0;
+#elif defined(__unix__)
+    rusage usage{};
+    if (0 != ::getrusage(RUSAGE_SELF, &usage)) return 0;
+    return std::uint64_t(usage.ru_maxrss);
+#else
+    return 0;
+#endif
+}
 
-    for (Subsystem& ss : system) {
+template <class E>
+void measureLocality(const SubsystemOf<E>& ss, Locality* result)
+    // Add the locality of the element buffers of `ss` to `*result`.  The
+    // address of an element is that of its first separately allocated part;
+    // every part counts toward the cache lines and pages touched.
+{
+    using std::uintptr_t;
+
+    std::vector<uintptr_t> addrs;
+    std::vector<uintptr_t> lines;
+    std::vector<uintptr_t> pages;
+    addrs.reserve(ss.size());
+    for (const E& e : ss) {
+        bool firstBlock = true;
+        ElementOps<E>::forEachBlock(e, [&](const void* p, std::size_t n) {
+            if (0 == n) return;
+            uintptr_t first = reinterpret_cast<uintptr_t>(p);
+            uintptr_t last  = first + n - 1;
+            if (firstBlock) addrs.push_back(first);
+            firstBlock = false;
+            for (uintptr_t l = first / cacheLineSize;
+                 l <= last / cacheLineSize; ++l)
+                lines.push_back(l);
+            for (uintptr_t pg = first / pageSize; pg <= last / pageSize; ++pg)
+                pages.push_back(pg);
+        });
+    }
+
+    if (addrs.empty()) return;
+
+    auto countDistinct = [](std::vector<uintptr_t>& v) {
+        std::sort(v.begin(), v.end());
+        return std::uint64_t(std::unique(v.begin(), v.end()) - v.begin());
+    };
+    result->cacheLines += countDistinct(lines);
+    result->pages      += countDistinct(pages);
+
+    std::vector<uintptr_t> sorted(addrs);
+    auto mid = sorted.begin() + sorted.size() / 2;
+    std::nth_element(sorted.begin(), mid, sorted.end());
+    const uintptr_t median = *mid;
+
+    for (uintptr_t addr : addrs) {
+        uintptr_t dist = addr > median ? addr - median : median - addr;
+        int b = 0;
+        while (b < numDistanceBuckets - 1 && dist >= distanceBounds[b]) ++b;
+        ++result->histogram[b];
+    }
+}
+
+// Result of running the benchmark on one partition.
+struct PartitionResult
+{
+    Interval    timed;
+    PhaseTimes  phaseTimes;
+    PhaseEvents events;    // All zero unless `countEvents`
+    Locality    locality;  // All zero unless `analyzeLocality`
+    Footprint   footprint;
+
+    // Empty unless `recordLatency`
+    LatencyHistogram churnLatency;
+    LatencyHistogram accessLatency;
+};
+
+// Result of one run of the benchmark: the wall-clock time for the whole
+// system, the time taken by each thread for its own partition, and the time
+// spent and hardware events counted in each phase and the final locality of
+// the subsystems and memory footprint, summed over all threads.  When the
+// test is repeated, this is the result of the repetition having the median
+// total time.
+struct TestResult
+{
+    chrono::milliseconds              total;
+    std::vector<chrono::milliseconds> perThread;
+    PhaseTimes                        phaseTimes;
+    PhaseEvents                       events;
+    Locality                          locality;
+    Footprint                         footprint;
+    LatencyHistogram                  churnLatency;
+    LatencyHistogram                  accessLatency;
+
+    // Set by `summarize` from all repetitions of the test: the total time of
+    // each repetition and the bounds of the confidence interval for the
+    // median total time.
+    std::vector<chrono::milliseconds> repTotals;
+    chrono::milliseconds              ciLow;
+    chrono::milliseconds              ciHigh;
+};
+
+// Guard that attributes the time spent, and the hardware events counted,
+// during its lifetime to one phase of a run.  Hardware events are counted only
+// if `counters_p` is not null.
+class PhaseScope
+{
+    chrono::nanoseconds              *m_time_p;
+    PerfScope                         m_perfScope;
+    chrono::steady_clock::time_point  m_start;
+
+  public:
+    PhaseScope(PartitionResult *result_p, Phase ph, PerfCounters *counters_p)
+        : m_time_p(&result_p->phaseTimes[ph])
+        , m_perfScope(counters_p, &result_p->events[ph])
+        , m_start(chrono::steady_clock::now()) { }
+
+    ~PhaseScope() { *m_time_p += chrono::steady_clock::now() - m_start; }
+
+    PhaseScope(const PhaseScope&) = delete;
+    PhaseScope& operator=(const PhaseScope&) = delete;
+};
+
+// Memory resource that counts the bytes and blocks allocated through it and
+// the peak number of bytes outstanding, getting its memory from the specified
+// upstream resource (by default, `new_delete_resource()`).  Not thread-safe.
+class CountingResource : public std::pmr::memory_resource
+{
+  public:
+    std::size_t bytes     = 0;
+    std::size_t blocks    = 0;
+    std::size_t liveBytes = 0;
+    std::size_t peakBytes = 0;
+
+    explicit CountingResource(std::pmr::memory_resource* upstream =
+                                  std::pmr::new_delete_resource())
+        : m_upstream(upstream) { }
+
+  private:
+    std::pmr::memory_resource* m_upstream;
+
+    void* do_allocate(std::size_t n, std::size_t align) override {
+        bytes += n;
+        ++blocks;
+        liveBytes += n;
+        peakBytes = std::max(peakBytes, liveBytes);
+        return m_upstream->allocate(n, align);
+    }
+
+    void do_deallocate(void* p, std::size_t n, std::size_t align) override {
+        liveBytes -= n;
+        m_upstream->deallocate(p, n, align);
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+        { return this == &other; }
+};
+
+// Memory resource that forwards to the specified upstream resource, which it
+// owns, and records the highest end address of the blocks it returns.  In
+// front of a monotonic resource, this shows how far into its buffer that
+// resource has allocated, without allocating from it.  Not thread-safe.
+class HighWaterResource : public std::pmr::memory_resource
+{
+  public:
+    explicit HighWaterResource(
+                      std::unique_ptr<std::pmr::memory_resource> upstream)
+        : m_upstream(std::move(upstream)) { }
+
+    // Return the highest end address of the blocks allocated, or zero if
+    // none have been.
+    std::uintptr_t highWater() const { return m_highWater; }
+
+  private:
+    std::unique_ptr<std::pmr::memory_resource> m_upstream;
+    std::uintptr_t                             m_highWater = 0;
+
+    void* do_allocate(std::size_t n, std::size_t align) override {
+        void* p = m_upstream->allocate(n, align);
+        m_highWater = std::max(m_highWater,
+                               reinterpret_cast<std::uintptr_t>(p) + n);
+        return p;
+    }
+
+    void do_deallocate(void* p, std::size_t n, std::size_t align) override
+        { m_upstream->deallocate(p, n, align); }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+        { return this == &other; }
+};
+
+// Memory resource that counts the bytes and blocks allocated by each thread,
+// getting its memory from `new_delete_resource()`.  During the footprint pass,
+// it is installed as the default resource, exposing allocations that bypass
+// the system's resource, such as those for the copy arm's temporary element.
+class ThreadCountingResource : public std::pmr::memory_resource
+{
+  public:
+    struct Counts
+    {
+        std::uint64_t bytes  = 0;
+        std::uint64_t blocks = 0;
+    };
+
+    // Return the totals allocated so far by the calling thread.
+    static Counts threadCounts() { return s_counts; }
+
+  private:
+    static thread_local Counts s_counts;
+
+    void* do_allocate(std::size_t n, std::size_t align) override {
+        s_counts.bytes += n;
+        ++s_counts.blocks;
+        return std::pmr::new_delete_resource()->allocate(n, align);
+    }
+
+    void do_deallocate(void* p, std::size_t n, std::size_t align) override
+        { std::pmr::new_delete_resource()->deallocate(p, n, align); }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+        { return this == &other; }
+};
+
+inline thread_local ThreadCountingResource::Counts
+    ThreadCountingResource::s_counts;
+
+template <class E>
+std::size_t elementFootprint()
+    // Return an upper bound on the number of bytes, including alignment
+    // padding, that a monotonic resource supplies for the parts of one
+    // initialized element of type `E`, not counting `sizeof(E)` itself.
+{
+    CountingResource counter;
+    {
+        std::pmr::polymorphic_allocator<char> alloc(&counter);
+        E e(alloc);
+        ElementOps<E>::init(&e, elemSize, 'A');
+    }
+    return counter.bytes + counter.blocks * (alignof(std::max_align_t) - 1);
+}
+
+MmapResource& mmapResource()
+    // Return the resource that maps memory as selected by the `mmap`, `thp`,
+    // and `populate` flags of `bufferFlags`.  It is shared by all threads.
+{
+    static MmapResource resource(
+        ((bufferFlags & bufHugePage) ? MmapResource::hugePages : 0) |
+        ((bufferFlags & bufPopulate) ? MmapResource::populate  : 0));
+    return resource;
+}
+
+std::pmr::memory_resource* upstreamResource()
+    // Return the resource from which the `grow`, `unsync`, and `sync`
+    // resources get their memory: `mmapResource()` if `-m` selected a mapped
+    // mode, and `new_delete_resource()` otherwise (and always for `newdel`,
+    // which allocates every element from it directly).
+{
+    if (ResourceKind::newDelete != resourceKind &&
+        (bufferFlags & (bufMmap | bufHugePage | bufPopulate)))
+        return &mmapResource();
+    return std::pmr::new_delete_resource();
+}
+
+std::unique_ptr<std::pmr::memory_resource>
+makeResource(void*                       buffer,
+             std::size_t                 bufferBytes,
+             std::pmr::memory_resource*  upstream)
+    // Return a new memory resource of the kind selected by `resourceKind` for
+    // allocating the subsystems of a partition, or null if the selected
+    // resource is the (unowned) `upstream` itself (`-r newdel`).  The
+    // monotonic resource allocates from the `bufferBytes` bytes at `buffer`;
+    // the others get their memory from `upstream`.
+{
+    using namespace std::pmr;
+
+    switch (resourceKind) {
+        case ResourceKind::monotonic:
+            return std::make_unique<monotonic_buffer_resource>(
+                buffer, bufferBytes, null_memory_resource());
+        case ResourceKind::growing:
+            return std::make_unique<monotonic_buffer_resource>(upstream);
+        case ResourceKind::unsyncPool:
+            return std::make_unique<unsynchronized_pool_resource>(upstream);
+        case ResourceKind::syncPool:
+            return std::make_unique<synchronized_pool_resource>(upstream);
+        case ResourceKind::newDelete:
+            return nullptr;
+    }
+
+    return nullptr;
+}
+
+template <Arm A, class E>
+PartitionResult runPartition(const Partition&   part,
+                             const std::string& label,
+                             std::barrier<>*    startSync)
+    // Build a system of `part.numSubsystems` subsystems using the memory
+    // resource selected by `resourceKind` (by default, a monotonic resource
+    // over `part.buffer`), then time `repCount` churn/access cycles on it.  If
+    // `startSync` is not null, wait on it between initialization and the timed
+    // section so that all threads start churning at the same time.  If
+    // `compactInterval` is nonzero, compact the system after every
+    // `compactInterval` churns.  The time spent in the initialization, churn,
+    // access, and compaction phases is accumulated separately and, if
+    // `countEvents` is true, so are hardware events.  If `footprintPass` is
+    // true, the bytes consumed from the resource and the allocations made
+    // from the default resource during churn are recorded.
+{
+    auto startInit = chrono::steady_clock::now();
+    auto snapShot  = startInit;
+
+    PartitionResult result{};
+
+    std::optional<PerfCounters> counters;
+    if (countEvents) counters.emplace();
+    PerfCounters *counters_p = counters ? &*counters : nullptr;
+
+    std::optional<PhaseScope> initScope(std::in_place, &result, initPhase,
+                                        counters_p);
+
+    void* buffers[2] = { part.buffer, part.spareBuffer };
+    int   curBuffer  = 0;
+
+    // To measure the footprint, resources other than the monotonic resource
+    // get their memory through `counter`, which records the peak number of
+    // bytes they hold (including while compacting, when two are live), and
+    // the monotonic resource is reached through a `HighWaterResource`.
+    CountingResource           counter(upstreamResource());
+    std::pmr::memory_resource *upstream =
+        footprintPass ? &counter : upstreamResource();
+    const bool   measureArena = (footprintPass &&
+                                 ResourceKind::monotonic == resourceKind);
+    std::uint64_t arenaPeak   = 0;
+
+    auto makeSystemResource = [&](void* buffer) {
+        std::unique_ptr<std::pmr::memory_resource> r =
+            makeResource(buffer, part.bufferBytes, upstream);
+        if (measureArena)
+            r = std::make_unique<HighWaterResource>(std::move(r));
+        return r;
+    };
+
+    std::unique_ptr<std::pmr::memory_resource> ownedRsrc =
+        makeSystemResource(buffers[curBuffer]);
+    std::pmr::memory_resource* rsrc =
+        ownedRsrc ? ownedRsrc.get() : upstream;
+
+    // Return the number of bytes of the current buffer consumed by the
+    // monotonic resource.
+    auto arenaBytesUsed = [&]() -> std::uint64_t {
+        const std::uintptr_t highWater =
+            static_cast<HighWaterResource*>(ownedRsrc.get())->highWater();
+        const std::uintptr_t base =
+            reinterpret_cast<std::uintptr_t>(buffers[curBuffer]);
+        return highWater > base ? highWater - base : 0;
+    };
+
+    auto system = std::make_unique<SystemOf<E>>(part.numSubsystems, rsrc);
+
+    for (SubsystemOf<E>& ss : *system) {
         initializeSubsystem(&ss);
     }
 
-    if (showProgress) progress(label, snapShot, 0, 0, "initialized");
+    initScope.reset();
+
+    if (showProgress) progress(label.c_str(), snapShot, 0, 0, "initialized");
 
     // // How long did initialization take?
     // auto initElapsedMs = chrono::duration_cast<chrono::milliseconds>(
     //     chrono::steady_clock::now() - startInit).count();
 
-    auto startTime = chrono::steady_clock::now();
+    if (startSync) startSync->arrive_and_wait();
+
+    Interval& timed = result.timed;
+    timed.start = chrono::steady_clock::now();
+
+    LatencyHistogram *churnLatency_p  =
+        recordLatency ? &result.churnLatency : nullptr;
+    LatencyHistogram *accessLatency_p =
+        recordLatency ? &result.accessLatency : nullptr;
+
+    Footprint& footprint = result.footprint;
 
     for (std::size_t n = 0; n < repCount; ++n) {
-        churn<UseCopy>(&system, churnCount);
-        if (showProgress) progress(label, snapShot, n, 0, "churned");
-        for (std::size_t ss = 0; ss < numSubsystems; ++ss) {
-	    accessSubsystem(&system[ss], accessCount);
+        const ThreadCountingResource::Counts defaultBefore =
+            ThreadCountingResource::threadCounts();
+        {
+            PhaseScope   scope(&result, churnPhase, counters_p);
+            LatencyScope latency(churnLatency_p);
+            churn<A, E>(system.get(), churnCount);
+        }
+        if (footprintPass) {
+            const ThreadCountingResource::Counts defaultAfter =
+                ThreadCountingResource::threadCounts();
+            footprint.defaultAllocs += (defaultAfter.blocks -
+                                        defaultBefore.blocks);
+            footprint.defaultBytes  += (defaultAfter.bytes -
+                                        defaultBefore.bytes);
+        }
+        if (showProgress) progress(label.c_str(), snapShot, n, 0, "churned");
+
+        if (compactInterval > 0 && 0 == (n + 1) % compactInterval) {
+            if (measureArena)
+                arenaPeak = std::max(arenaPeak, arenaBytesUsed());
+
+            // Copy each subsystem into a fresh resource (using the other
+            // buffer), then release the old system and its resource.
+            PhaseScope scope(&result, compactPhase, counters_p);
+            curBuffer = 1 - curBuffer;
+            std::unique_ptr<std::pmr::memory_resource> newRsrc =
+                makeSystemResource(buffers[curBuffer]);
+            rsrc = newRsrc ? newRsrc.get() : upstream;
+
+            auto fresh = std::make_unique<SystemOf<E>>(rsrc);
+            fresh->reserve(system->size());
+            for (const SubsystemOf<E>& ss : *system) {
+                fresh->emplace_back(ss);
+            }
+
+            system    = std::move(fresh);    // Destroys the old system
+            ownedRsrc = std::move(newRsrc);  // then its resource
+        }
+
+        PhaseScope scope(&result, accessPhase, counters_p);
+        for (std::size_t ss = 0; ss < part.numSubsystems; ++ss) {
+            {
+                LatencyScope latency(accessLatency_p);
+                accessSubsystem(&(*system)[ss], accessCount);
+            }
             if (showProgress)
-                progress(label, snapShot, n, ss, "accessed");
+                progress(label.c_str(), snapShot, n, ss, "accessed");
         }
     }
 
-    auto stopTime = chrono::steady_clock::now();
-    auto elapsed =
-        chrono::duration_cast<chrono::milliseconds>(stopTime-startTime);
+    timed.stop = chrono::steady_clock::now();
+
+    if (footprintPass) {
+        footprint.arenaBytes = (measureArena ?
+                                std::max(arenaPeak, arenaBytesUsed()) :
+                                counter.peakBytes);
+    }
+
+    // Analyze the final layout outside of the timed section.
+    if (analyzeLocality) {
+        for (const SubsystemOf<E>& ss : *system) {
+            measureLocality(ss, &result.locality);
+        }
+    }
 
     if (showProgress)
-        std::cerr << label << " finished in " << elapsed.count() << "ms\n";
+        std::cerr << label << " finished in " << timed.elapsed().count()
+                  << "ms\n";
+
+    return result;
+}
+
+template <Arm A, class E>
+TestResult doTest(const std::vector<Partition>& partitions)
+{
+    static constexpr const char* label =
+        (Arm::copy == A ? "[copy]" : Arm::move == A ? "[move]" : "[relocate]");
+
+    const std::size_t nThreads = partitions.size();
+
+    std::vector<PartitionResult> partResults(nThreads);
+
+    if (footprintPass) resetPeakRss();
+
+    if (1 == nThreads) {
+        partResults[0] = runPartition<A, E>(partitions[0], label, nullptr);
+    }
+    else {
+        // Each thread works on its own partition.  The threads wait for each
+        // other after initialization so that they all start churning at the
+        // same time.
+        std::barrier<> startSync(nThreads);
+        std::vector<std::thread> threads;
+        threads.reserve(nThreads);
+        for (std::size_t t = 0; t < nThreads; ++t) {
+            threads.emplace_back([&, t]{
+                threadIndex = t;
+                // E.g., "[copy:3]" for thread 3
+                std::string threadLabel(label, std::strlen(label) - 1);
+                threadLabel += ':' + std::to_string(t) + ']';
+                partResults[t] = runPartition<A, E>(partitions[t],
+                                                    threadLabel,
+                                                    &startSync);
+            });
+        }
+
+        for (std::thread& th : threads) {
+            th.join();
+        }
+    }
+
+    // The aggregate time spans from the earliest start to the latest stop.
+    // Event counts are summed over all threads.
+    TestResult result{};
+    result.perThread.resize(nThreads);
+    Interval all = partResults[0].timed;
+    for (std::size_t t = 0; t < nThreads; ++t) {
+        const PartitionResult& pr = partResults[t];
+        all.start = std::min(all.start, pr.timed.start);
+        all.stop  = std::max(all.stop,  pr.timed.stop);
+        result.perThread[t] = pr.timed.elapsed();
+        for (int ph = 0; ph < numPhases; ++ph) {
+            result.phaseTimes[ph] += pr.phaseTimes[ph];
+            for (int e = 0; e < numPerfEvents; ++e) {
+                result.events[ph][e] += pr.events[ph][e];
+            }
+        }
+        result.locality  += pr.locality;
+        result.footprint += pr.footprint;
+        result.churnLatency  += pr.churnLatency;
+        result.accessLatency += pr.accessLatency;
+    }
+    result.total = all.elapsed();
+    if (footprintPass) result.footprint.peakRssKiB = peakRssKiB();
+
+    if (showProgress && nThreads > 1)
+        std::cerr << label << " all threads finished in "
+                  << result.total.count() << "ms\n";
+
+    return result;
+}
+
+template <class F>
+decltype(auto) withElementType(F&& f)
+    // Return `f(std::type_identity<E>{})`, where `E` is the element type
+    // selected by `elementKind`.
+{
+    switch (elementKind) {
+        case ElementKind::bytes:   return f(std::type_identity<Bytes>{});
+        case ElementKind::string:  return f(std::type_identity<String>{});
+        case ElementKind::samples: return f(std::type_identity<Samples>{});
+        case ElementKind::list:    return f(std::type_identity<List>{});
+        case ElementKind::hashMap: return f(std::type_identity<HashMap>{});
+        case ElementKind::mixed:   return f(std::type_identity<Mixed>{});
+    }
+
+    return f(std::type_identity<Bytes>{});
+}
+
+TestResult runArm(Arm arm, const std::vector<Partition>& partitions)
+    // Run the test once using the specified `arm` and the element type
+    // selected by `elementKind`.
+{
+    return withElementType([&](auto tag) {
+        using E = typename decltype(tag)::type;
+        switch (arm) {
+            case Arm::copy:     return doTest<Arm::copy, E>(partitions);
+            case Arm::move:     return doTest<Arm::move, E>(partitions);
+            case Arm::relocate: return doTest<Arm::relocate, E>(partitions);
+        }
+        return TestResult{};
+    });
+}
+
+std::pair<std::size_t, std::size_t> medianCIRanks(std::size_t n)
+    // Return the (zero-based) ranks of the order statistics of `n` samples
+    // that bound a distribution-free 95% confidence interval for the median.
+    // The lower rank is the largest `j` such that `P(X < j+1) <= 0.025` for `X
+    // ~ Binomial(n, 1/2)`.  For `n < 6`, no such interval exists, and the
+    // interval is the full range of the samples (e.g., 94% for `n == 5`).
+{
+    std::size_t j    = 0;
+    double      pmf  = std::pow(0.5, double(n));  // P(X == 0)
+    double      less = pmf;                       // P(X < j+1)
+    while (j + 1 < n) {
+        pmf *= double(n - j) / double(j + 1);     // P(X == j+1)
+        if (less + pmf > 0.025) break;
+        less += pmf;
+        ++j;
+    }
+
+    return { j, n - 1 - j };
+}
+
+TestResult summarize(std::vector<TestResult>* samples)
+    // Return the element of `*samples` having the median total time (the lower
+    // median if there is an even number of samples), with the total time of
+    // every sample and the 95% confidence interval of the median filled in.
+{
+    const std::size_t n = samples->size();
+
+    std::vector<chrono::milliseconds> totals;
+    totals.reserve(n);
+    for (const TestResult& sample : *samples) {
+        totals.push_back(sample.total);
+    }
+
+    std::vector<chrono::milliseconds> sorted(totals);
+    std::sort(sorted.begin(), sorted.end());
+
+    const chrono::milliseconds median = sorted[(n - 1) / 2];
+    auto medianIter = std::find_if(samples->begin(), samples->end(),
+                                   [median](const TestResult& sample) {
+                                       return median == sample.total;
+                                   });
+
+    TestResult result = std::move(*medianIter);
+    auto [low, high] = medianCIRanks(n);
+    result.repTotals = std::move(totals);
+    result.ciLow     = sorted[low];
+    result.ciHigh    = sorted[high];
+
+    return result;
+}
+
+bool overlaps(const TestResult& a, const TestResult& b)
+    // Return true if the confidence intervals of `a` and `b` overlap.
+{
+    return a.ciLow <= b.ciHigh && b.ciLow <= a.ciHigh;
+}
+
+std::size_t parseSize(const char* str);
+
+const char* optionValue(const char* argv[], int argc, int& arg, int& i)
+    // Return the value of the option whose letter is `argv[arg][i]`. The value
+    // is the rest of `argv[arg]` (e.g., `-t4`) or, if that is empty, the
+    // following argument (e.g., `-t 4`). On return, `arg` and `i` are updated
+    // such that option processing resumes with the argument after the value.
+{
+    const char* value = &argv[arg][i + 1];
+    if ('\0' == *value) {
+        if (++arg >= argc) {
+            std::cerr << "Option -" << argv[arg - 1][i]
+                      << " requires a value" << std::endl;
+            std::exit(1);
+        }
+        value = argv[arg];
+    }
+    i = int(std::strlen(argv[arg])) - 1;  // Skip rest of current argument
+    return value;
+}
+
+ResourceKind parseResource(const char* str)
+    // Return the resource kind named by `str` (see `resourceNames`).
+{
+    for (const ResourceName& rn : resourceNames) {
+        if (0 == std::strcmp(str, rn.name)) return rn.kind;
+    }
+
+    std::cerr << "Error: Bad resource name: " << str << " (expected one of";
+    for (const ResourceName& rn : resourceNames) {
+        std::cerr << ' ' << rn.name;
+    }
+    std::cerr << ')' << std::endl;
+    std::exit(1);
+}
+
+ElementKind parseElementKind(const char* str)
+    // Return the element kind named by `str` (see `elementNames`).
+{
+    for (const ElementName& en : elementNames) {
+        if (0 == std::strcmp(str, en.name)) return en.kind;
+    }
+
+    std::cerr << "Error: Bad element type: " << str << " (expected one of";
+    for (const ElementName& en : elementNames) {
+        std::cerr << ' ' << en.name;
+    }
+    std::cerr << ')' << std::endl;
+    std::exit(1);
+}
+
+const char* elementKindName(ElementKind kind)
+{
+    for (const ElementName& en : elementNames) {
+        if (en.kind == kind) return en.name;
+    }
+    return "?";
+}
+
+const char* resourceName(ResourceKind kind)
+{
+    for (const ResourceName& rn : resourceNames) {
+        if (rn.kind == kind) return rn.name;
+    }
+    return "?";
+}
+
+int parseBufferFlags(const char* str)
+    // Return the `BufferFlags` named in the `+`-separated list `str`, or 0 if
+    // `str` is "new".
+{
+    if (0 == std::strcmp(str, "new")) return 0;
+
+    int flags = 0;
+    for (const char* cursor = str; ; ++cursor) {
+        std::size_t len = std::strcspn(cursor, "+");
+        int flag = 0;
+        for (const BufferFlagName& bn : bufferFlagNames) {
+            if (len == std::strlen(bn.name) &&
+                0 == std::strncmp(cursor, bn.name, len))
+                flag = bn.flag;
+        }
+        if (0 == flag) {
+            std::cerr << "Error: Bad buffer mode: " << str << " (expected new "
+                "or a +-separated list of mmap thp populate touch)"
+                      << std::endl;
+            std::exit(1);
+        }
+        flags |= flag;
+        cursor += len;
+        if ('\0' == *cursor) break;
+    }
+
+    return flags;
+}
+
+std::string bufferModeName(int flags)
+    // Return the name of the buffer mode specified by `flags` in the format
+    // parsed by `parseBufferFlags`.
+{
+    if (0 == flags) return "new";
+
+    std::string result;
+    for (const BufferFlagName& bn : bufferFlagNames) {
+        if (flags & bn.flag) {
+            if (! result.empty()) result += '+';
+            result += bn.name;
+        }
+    }
+    return result;
+}
+
+void parseChurnPattern(const char* str)
+    // Set `churnPattern`, and `zipfSkew` or `batchSize`, from `str`, which is
+    // `uniform`, `neighbor`, `zipf[:SKEW]`, or `batch[:SIZE]`.
+{
+    const char* param = std::strchr(str, ':');
+    std::string name(str, param ? param - str : std::strlen(str));
+    if (param) ++param;
+
+    if ("uniform" == name && ! param) {
+        churnPattern = ChurnPattern::uniform;
+    }
+    else if ("neighbor" == name && ! param) {
+        churnPattern = ChurnPattern::neighbor;
+    }
+    else if ("zipf" == name) {
+        churnPattern = ChurnPattern::zipf;
+        if (param) {
+            char* end;
+            zipfSkew = std::strtod(param, &end);
+            if (end == param || *end || zipfSkew < 0) {
+                std::cerr << "Error: Bad Zipf skew: " << param << std::endl;
+                std::exit(1);
+            }
+        }
+    }
+    else if ("batch" == name) {
+        churnPattern = ChurnPattern::batch;
+        if (param) batchSize = parseSize(param);
+        if (batchSize < 1) {
+            std::cerr << "Error: Batch size must be at least 1" << std::endl;
+            std::exit(1);
+        }
+    }
+    else {
+        std::cerr << "Error: Bad churn pattern: " << str << " (expected one "
+            "of uniform zipf[:SKEW] neighbor batch[:SIZE])" << std::endl;
+        std::exit(1);
+    }
+}
 
-    return elapsed;
+std::string churnPatternName()
+    // Return the name of the churn pattern in the format parsed by
+    // `parseChurnPattern`.
+{
+    std::ostringstream os;
+    switch (churnPattern) {
+        case ChurnPattern::uniform:  os << "uniform";                  break;
+        case ChurnPattern::zipf:     os << "zipf:" << zipfSkew;        break;
+        case ChurnPattern::neighbor: os << "neighbor";                 break;
+        case ChurnPattern::batch:    os << "batch:" << batchSize;      break;
+    }
+    return os.str();
+}
+
+AccessKernel parseAccessKernel(const char* str)
+{
+    if (0 == std::strcmp(str, "scalar")) return AccessKernel::scalar;
+    if (0 == std::strcmp(str, "vector")) return AccessKernel::vector;
+
+    std::cerr << "Error: Bad access kernel: " << str
+              << " (expected one of scalar vector)" << std::endl;
+    std::exit(1);
+}
+
+const char* accessKernelName(AccessKernel kernel)
+{
+    return AccessKernel::vector == kernel ? "vector" : "scalar";
+}
+
+OutputFormat parseOutputFormat(const char* str)
+{
+    if (0 == std::strcmp(str, "text")) return OutputFormat::text;
+    if (0 == std::strcmp(str, "csv"))  return OutputFormat::csv;
+    if (0 == std::strcmp(str, "json")) return OutputFormat::json;
+
+    std::cerr << "Error: Bad output format: " << str
+              << " (expected one of text csv json)" << std::endl;
+    std::exit(1);
 }
 
 void processOptions(const char* argv[], int argc, int& arg)
@@ -198,6 +1655,47 @@ void processOptions(const char* argv[], int argc, int& arg)
             switch (argv[arg][i]) {
                 case 'v' : verbose = true; break;
                 case 'p' : showProgress = true; break;
+                case 'c' : countEvents = true; break;
+                case 'd' : runRelocate = true; break;
+                case 'l' : analyzeLocality = true; break;
+                case 'h' : recordLatency = true; break;
+                case 'f' : measureFootprint = true; break;
+                case 'z' :
+                    compactInterval =
+                        parseSize(optionValue(argv, argc, arg, i));
+                    break;
+                case 't' :
+                    numThreads = parseSize(optionValue(argv, argc, arg, i));
+                    break;
+                case 'w' :
+                    warmupCount = parseSize(optionValue(argv, argc, arg, i));
+                    break;
+                case 'n' :
+                    repetitions = parseSize(optionValue(argv, argc, arg, i));
+                    break;
+                case 'r' :
+                    resourceKind =
+                        parseResource(optionValue(argv, argc, arg, i));
+                    break;
+                case 'm' :
+                    bufferFlags =
+                        parseBufferFlags(optionValue(argv, argc, arg, i));
+                    break;
+                case 's' :
+                    parseChurnPattern(optionValue(argv, argc, arg, i));
+                    break;
+                case 'e' :
+                    elementKind =
+                        parseElementKind(optionValue(argv, argc, arg, i));
+                    break;
+                case 'k' :
+                    accessKernel =
+                        parseAccessKernel(optionValue(argv, argc, arg, i));
+                    break;
+                case 'o' :
+                    outputFormat =
+                        parseOutputFormat(optionValue(argv, argc, arg, i));
+                    break;
                 default  :
                     std::cerr << "Invalid option -" << argv[arg][i]
                               << std::endl;
@@ -297,11 +1795,486 @@ std::size_t parseArg(const char* argv[], int argc, int& arg, std::size_t dflt)
         return dflt;
 }
 
+void touchPages(void* buffer, std::size_t bytes)
+    // Write to every page of the specified `buffer` so that it is faulted in.
+{
+    volatile char* p = static_cast<char*>(buffer);
+    for (std::size_t offset = 0; offset < bytes; offset += pageSize) {
+        p[offset] = 0;
+    }
+}
+
+void* allocateBuffer(std::size_t bytes)
+    // Return a buffer of at least the specified `bytes` obtained as selected
+    // by `bufferFlags`.  The buffer is never freed.
+{
+    void* buffer = nullptr;
+
+    if (0 == (bufferFlags & (bufMmap | bufHugePage | bufPopulate))) {
+        buffer = ::operator new(bytes);
+    }
+    else {
+#ifdef __linux__
+        MmapResource& mapper = mmapResource();
+        const std::size_t failures = mapper.adviceFailures();
+        try {
+            buffer = mapper.allocate(bytes, pageSize);
+        }
+        catch (const std::bad_alloc&) {
+            std::cerr << "Error: mmap of " << bytes << " bytes failed: "
+                      << std::strerror(errno) << std::endl;
+            std::exit(1);
+        }
+        if (mapper.adviceFailures() != failures)
+            std::cerr << "Warning: madvise(MADV_HUGEPAGE) failed: "
+                      << std::strerror(mapper.lastAdviceError()) << std::endl;
+#else
+        std::cerr << "Error: Buffer mode " << bufferModeName(bufferFlags)
+                  << " is supported only on Linux" << std::endl;
+        std::exit(1);
+#endif
+    }
+
+    if (bufferFlags & bufTouch) touchPages(buffer, bytes);
+
+    return buffer;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// STRUCTURED (CSV AND JSON) OUTPUT
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef BUILD_FLAGS
+# define BUILD_FLAGS "unknown"  // Normally defined by the Makefile
+#endif
+
+#if defined(__clang__)
+# define COMPILER_VERSION "clang++ " __clang_version__
+#elif defined(__GNUC__)
+# define COMPILER_VERSION "g++ " __VERSION__
+#else
+# define COMPILER_VERSION "unknown"
+#endif
+
+// A named value in a structured result record.  Nested values are flattened
+// using dotted names, e.g., `copy.churnMs`, so that the same record can be
+// printed as either a CSV row or a JSON object.
+struct Field
+{
+    std::string name;
+    std::string value;
+    bool        isString;
+};
+
+using Record = std::vector<Field>;
+
+void addField(Record* rec, std::string name, std::string value)
+{
+    rec->push_back({ std::move(name), std::move(value), true });
+}
+
+void addField(Record* rec, std::string name, const char* value)
+{
+    addField(rec, std::move(name), std::string(value));
+}
+
+void addField(Record* rec, std::string name, bool value)
+{
+    rec->push_back({ std::move(name), value ? "true" : "false", false });
+}
+
+template <typename Number>
+void addField(Record* rec, std::string name, Number value)
+{
+    static_assert(std::is_arithmetic_v<Number>);
+
+    std::ostringstream os;
+    if constexpr (std::is_floating_point_v<Number>)
+        os << std::fixed << std::setprecision(3);
+    os << value;
+    rec->push_back({ std::move(name), os.str(), false });
+}
+
+std::string cpuModel()
+    // Return the CPU model name reported by the operating system.
+{
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (0 == line.compare(0, 10, "model name")) {
+            std::size_t colon = line.find(':');
+            if (colon != std::string::npos)
+                return line.substr(line.find_first_not_of(" \t", colon + 1));
+        }
+    }
+    return "unknown";
+}
+
+void addEnvironmentFields(Record* rec)
+    // Append fields describing the machine, compiler, and time of the run.
+{
+    std::string host = "unknown", kernel = "unknown";
+#ifdef __unix__
+    struct utsname uts;
+    if (0 == ::uname(&uts)) {
+        host   = uts.nodename;
+        kernel = std::string(uts.sysname) + ' ' + uts.release;
+    }
+#endif
+
+    char timestamp[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ",
+                  std::gmtime(&now));
+
+    addField(rec, "env.cpu",       cpuModel());
+    addField(rec, "env.cpus",      std::thread::hardware_concurrency());
+    addField(rec, "env.host",      host);
+    addField(rec, "env.kernel",    kernel);
+    addField(rec, "env.compiler",  COMPILER_VERSION);
+    addField(rec, "env.flags",     BUILD_FLAGS);
+    addField(rec, "env.timestamp", std::string(timestamp));
+}
+
+void addResultFields(Record* rec, const char* arm, const TestResult& result)
+    // Append the fields of `result` to `rec`, prefixing each name with `arm`.
+{
+    using MsDouble = chrono::duration<double, std::milli>;
+
+    const std::string prefix = std::string(arm) + '.';
+
+    addField(rec, prefix + "totalMs", result.total.count());
+    if (repetitions > 1) {
+        addField(rec, prefix + "ciLowMs",  result.ciLow.count());
+        addField(rec, prefix + "ciHighMs", result.ciHigh.count());
+        for (std::size_t n = 0; n < result.repTotals.size(); ++n) {
+            addField(rec, prefix + "rep" + std::to_string(n) + "Ms",
+                     result.repTotals[n].count());
+        }
+    }
+    for (std::size_t t = 0; t < result.perThread.size(); ++t) {
+        addField(rec, prefix + "thread" + std::to_string(t) + "Ms",
+                 result.perThread[t].count());
+    }
+    for (int ph = 0; ph < numPhases; ++ph) {
+        if (! phaseReported(ph)) continue;
+        addField(rec, prefix + phaseNames[ph] + "Ms",
+                 MsDouble(result.phaseTimes[ph]).count());
+    }
+    if (countEvents) {
+        for (int ph = 0; ph < numPhases; ++ph) {
+            if (! phaseReported(ph)) continue;
+            for (int e = 0; e < numPerfEvents; ++e) {
+                if (! eventAvailable[e]) continue;
+                addField(rec, (prefix + phaseNames[ph] + '.' +
+                               PerfCounters::name(PerfEvent(e))),
+                         result.events[ph][e]);
+            }
+        }
+    }
+    if (recordLatency) {
+        auto addLatency = [&](const char* name, const LatencyHistogram& hist) {
+            for (const Quantile& q : latencyQuantiles) {
+                addField(rec, prefix + name + '.' + q.name + "Ns",
+                         hist.percentile(q.fraction).count());
+            }
+            addField(rec, prefix + name + ".maxNs", hist.max().count());
+        };
+        addLatency("churnLat",  result.churnLatency);
+        addLatency("accessLat", result.accessLatency);
+    }
+    if (analyzeLocality) {
+        for (int b = 0; b < numDistanceBuckets; ++b) {
+            addField(rec, prefix + "dist." + distanceBucketNames[b],
+                     result.locality.histogram[b]);
+        }
+        addField(rec, prefix + "cacheLines", result.locality.cacheLines);
+        addField(rec, prefix + "pages",      result.locality.pages);
+    }
+    if (measureFootprint) {
+        const Footprint& fp = result.footprint;
+        addField(rec, prefix + "arenaBytes",    fp.arenaBytes);
+        addField(rec, prefix + "defaultAllocs", fp.defaultAllocs);
+        addField(rec, prefix + "defaultBytes",  fp.defaultBytes);
+        addField(rec, prefix + "peakRssKiB",    fp.peakRssKiB);
+    }
+}
+
+Record makeRecord(const TestResult& copyResult,
+                  const TestResult& moveResult,
+                  const TestResult* relocateResult)
+    // Return a record of the parameters, results, and environment of a run.
+    // `relocateResult` is null unless `runRelocate`.
+{
+    Record rec;
+
+    addField(&rec, "systemSize",     systemSize);
+    addField(&rec, "numSubsystems",  numSubsystems);
+    addField(&rec, "elemsPerSubsys", elemsPerSubsys);
+    addField(&rec, "elemSize",       elemSize);
+    addField(&rec, "churnCount",     churnCount);
+    addField(&rec, "accessCount",    accessCount);
+    addField(&rec, "repCount",       repCount);
+    addField(&rec, "numThreads",     numThreads);
+    addField(&rec, "warmupCount",    warmupCount);
+    addField(&rec, "repetitions",    repetitions);
+    addField(&rec, "resource",       resourceName(resourceKind));
+    addField(&rec, "bufferMode",     bufferModeName(bufferFlags));
+    addField(&rec, "accessKernel",   accessKernelName(accessKernel));
+    addField(&rec, "elementType",    elementKindName(elementKind));
+    addField(&rec, "churnPattern",   churnPatternName());
+    addField(&rec, "runRelocate",    runRelocate);
+    addField(&rec, "countEvents",    countEvents);
+    addField(&rec, "analyzeLocality", analyzeLocality);
+    addField(&rec, "recordLatency",  recordLatency);
+    addField(&rec, "compactInterval", compactInterval);
+    addField(&rec, "measureFootprint", measureFootprint);
+
+    addResultFields(&rec, "copy", copyResult);
+    addResultFields(&rec, "move", moveResult);
+    if (relocateResult) addResultFields(&rec, "relocate", *relocateResult);
+
+    // Percent of copy time used by move (as computed by `runtest`)
+    double copyMs = double(copyResult.total.count());
+    addField(&rec, "movePct",
+             copyMs > 0 ? 100.0 * double(moveResult.total.count()) / copyMs
+                        : 0.0);
+    if (relocateResult) {
+        addField(&rec, "relocatePct",
+                 copyMs > 0 ?
+                 100.0 * double(relocateResult->total.count()) / copyMs : 0.0);
+    }
+
+    // A difference from copy is inconclusive if the confidence intervals
+    // overlap.
+    if (repetitions > 1) {
+        addField(&rec, "move.inconclusive", overlaps(copyResult, moveResult));
+        if (relocateResult)
+            addField(&rec, "relocate.inconclusive",
+                     overlaps(copyResult, *relocateResult));
+    }
+
+    addEnvironmentFields(&rec);
+
+    return rec;
+}
+
+void printQuoted(std::ostream& os, const std::string& str)
+    // Print `str` as a quoted CSV or JSON string, according to `outputFormat`.
+{
+    const bool json = (OutputFormat::json == outputFormat);
+
+    os << '"';
+    for (char c : str) {
+        if ('"' == c)
+            os << (json ? "\\\"" : "\"\"");
+        else if (json && '\\' == c)
+            os << "\\\\";
+        else if (json && static_cast<unsigned char>(c) < 0x20)
+            os << ' ';
+        else
+            os << c;
+    }
+    os << '"';
+}
+
+void printRecord(std::ostream& os, const Record& rec)
+    // Print `rec` in the `csv` format (a header line followed by a line of
+    // values) or in the `json` format (a single-line JSON object), according
+    // to `outputFormat`.
+{
+    const char* sep = "";
+    if (OutputFormat::csv == outputFormat) {
+        for (const Field& f : rec) {
+            os << sep << f.name;
+            sep = ",";
+        }
+        os << '\n';
+        sep = "";
+        for (const Field& f : rec) {
+            os << sep;
+            if (f.isString) printQuoted(os, f.value); else os << f.value;
+            sep = ",";
+        }
+        os << std::endl;
+    }
+    else {
+        os << '{';
+        for (const Field& f : rec) {
+            os << sep;
+            printQuoted(os, f.name);
+            os << ':';
+            if (f.isString) printQuoted(os, f.value); else os << f.value;
+            sep = ",";
+        }
+        os << '}' << std::endl;
+    }
+}
+
+void printTextResults(const TestResult& copyResult,
+                      const TestResult& moveResult,
+                      const TestResult* relocateResult)
+    // Print the results in the `text` format (see `main`).  `relocateResult`
+    // is null unless `runRelocate`.
+{
+    std::cout << copyResult.total.count() << std::endl;
+    std::cout << moveResult.total.count() << std::endl;
+
+    // The relocation time comes right after the move time, so that its
+    // position does not depend on the options below.
+    if (relocateResult)
+        std::cout << relocateResult->total.count() << std::endl;
+
+    if (ResourceKind::monotonic != resourceKind)
+        std::cout << resourceName(resourceKind) << std::endl;
+
+    if (0 != bufferFlags)
+        std::cout << bufferModeName(bufferFlags) << std::endl;
+
+    if (AccessKernel::scalar != accessKernel)
+        std::cout << accessKernelName(accessKernel) << std::endl;
+
+    if (ElementKind::bytes != elementKind)
+        std::cout << elementKindName(elementKind) << std::endl;
+
+    if (ChurnPattern::uniform != churnPattern)
+        std::cout << churnPatternName() << std::endl;
+
+    std::vector<const TestResult*> results{ &copyResult, &moveResult };
+    if (relocateResult) results.push_back(relocateResult);
+
+    if (numThreads > 1) {
+        for (const TestResult* result : results) {
+            const char* sep = "";
+            for (chrono::milliseconds ms : result->perThread) {
+                std::cout << sep << ms.count();
+                sep = ",";
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    if (countEvents) {
+        for (const TestResult* result : results) {
+            const char* sep = "";
+            for (int ph = 0; ph < numPhases; ++ph) {
+                if (! phaseReported(ph)) continue;
+                for (int e = 0; e < numPerfEvents; ++e) {
+                    std::cout << sep;
+                    if (eventAvailable[e])
+                        std::cout << result->events[ph][e];
+                    else
+                        std::cout << "NA";
+                    sep = ",";
+                }
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    if (analyzeLocality) {
+        for (const TestResult* result : results) {
+            for (std::uint64_t count : result->locality.histogram) {
+                std::cout << count << ',';
+            }
+            std::cout << result->locality.cacheLines << ','
+                      << result->locality.pages << std::endl;
+        }
+    }
+
+    if (recordLatency) {
+        for (const TestResult* result : results) {
+            const char* sep = "";
+            for (const LatencyHistogram* hist : { &result->churnLatency,
+                                                  &result->accessLatency }) {
+                for (const Quantile& q : latencyQuantiles) {
+                    std::cout << sep << hist->percentile(q.fraction).count();
+                    sep = ",";
+                }
+                std::cout << sep << hist->max().count();
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    if (compactInterval > 0) {
+        using MsDouble = chrono::duration<double, std::milli>;
+        for (const TestResult* result : results) {
+            std::cout << std::fixed << std::setprecision(3)
+                      << MsDouble(result->phaseTimes[compactPhase]).count()
+                      << ','
+                      << MsDouble(result->phaseTimes[accessPhase]).count()
+                      << std::defaultfloat << std::endl;
+        }
+    }
+
+    if (measureFootprint) {
+        for (const TestResult* result : results) {
+            const Footprint& fp = result->footprint;
+            std::cout << fp.arenaBytes    << ',' << fp.defaultAllocs << ','
+                      << fp.defaultBytes  << ',' << fp.peakRssKiB
+                      << std::endl;
+        }
+    }
+
+    if (repetitions > 1) {
+        std::cout << "ci";
+        for (const TestResult* result : results) {
+            std::cout << ',' << result->ciLow.count()
+                      << ',' << result->ciHigh.count();
+        }
+        std::cout << std::endl;
+    }
+}
+
 // Main program parses arguments and runs tests.  It prints three
 // newline-separated strings to standard out:
 // 1. The list of test parameters (comma separated with no whitespace)
 // 2. The time in ms for running the test using copy assingment
 // 3. The time in ms for running the test using move assingment
+// With `-d`, a fourth line has the time in ms for running the test using
+// relocation.  Options may add further lines after these, each of which is a
+// comma separated list with no whitespace:
+// * `-r NAME` (other than `mono`): the name of the memory resource used.
+// * `-m MODE` (other than `new`): the buffer mode used.
+// * `-k vector`: the name of the access kernel used.
+// * `-e TYPE` (other than `bytes`): the name of the element type used.
+// * `-s PATTERN` (other than `uniform`): the churn pattern used.
+// * `-t N` (N > 1): the per-thread times in ms using copy assignment, followed
+//   by a line with the per-thread times in ms using move assignment (and, with
+//   `-d`, another using relocation).
+// * `-c`: hardware event counts using copy assignment, followed by a line with
+//   the counts using move assignment (and, with `-d`, another using
+//   relocation).  Each line has the counts of L1D read misses, LLC read
+//   misses, dTLB read misses, instructions, and cycles, for each of the init,
+//   churn, and access phases (and, with `-z`, the compact phase), in that
+//   order, summed over all threads.  Counters that are not available print as `NA`; if none are
+//   available, these lines are omitted.
+// * `-l`: the locality of the element buffers after the last churn using copy
+//   assignment, followed by a line for move assignment (and, with `-d`,
+//   another for relocation).  Each line has the number of elements whose
+//   buffer is less than 64B, 4KiB, 256KiB, 16MiB, and at least 16MiB from the
+//   median buffer address of its subsystem, followed by the number of
+//   distinct cache lines and pages touched by the element buffers of each
+//   subsystem, all summed over all subsystems.
+// * `-h`: the p50, p99, p999, and maximum latency, in ns, of the calls to
+//   `churn` followed by those of the calls to `accessSubsystem`, using copy
+//   assignment, followed by a line for move assignment (and, with `-d`,
+//   another for relocation).
+// * `-z K`: the total time in ms spent compacting, followed by the total time
+//   in ms spent in the access phase, using copy assignment, followed by a line
+//   for move assignment (and, with `-d`, another for relocation).
+// * `-f`: the bytes consumed from the memory resource, the number of
+//   allocations and bytes allocated from the default resource during churn,
+//   and the peak resident set size in KiB, using copy assignment, followed by
+//   a line for move assignment (and, with `-d`, another for relocation).
+// * `-n N` (N > 1): `ci` followed by the lower and upper bounds, in ms, of the
+//   95% confidence interval of the median time using copy assignment, then of
+//   the median time using move assignment (and, with `-d`, relocation).
+// With `-n N`, the times on lines 2 and 3 (and all other results) are those
+// of the repetition having the median time.
+// With `-o csv` or `-o json`, the above is replaced by a single structured
+// record (see `makeRecord`).
 int main(int argc, const char *argv[])
 {
     int a = 1;
@@ -360,13 +2333,30 @@ int main(int argc, const char *argv[])
     if (placeholderArg == accessCount) accessCount = 8;
     if (placeholderArg == repCount   ) repCount    = 4*KiB;
 
-    std::cout << PrintSize(systemSize)     << ','
-              << PrintSize(numSubsystems)  << ','
-              << PrintSize(elemsPerSubsys) << ','
-              << PrintSize(elemSize)       << ','
-              << PrintSize(churnCount)     << ','
-              << PrintSize(accessCount)    << ','
-              << PrintSize(repCount)       << std::endl;
+    if ((bufferFlags & bufTouch) && ResourceKind::monotonic != resourceKind)
+        std::cerr << "Warning: -m touch applies only to the mono resource\n";
+    if (bufferFlags && ResourceKind::newDelete == resourceKind)
+        std::cerr << "Warning: -m does not apply to the newdel resource\n";
+
+    if (repetitions < 1) {
+        std::cerr << "Error: Number of repetitions must be at least 1\n";
+        return 1;
+    }
+
+    if (numThreads < 1 || numThreads > numSubsystems) {
+        std::cerr << "Error: number of threads must be between 1 and "
+            "numSubsystems\n";
+        return 1;
+    }
+
+    if (OutputFormat::text == outputFormat)
+        std::cout << PrintSize(systemSize)     << ','
+                  << PrintSize(numSubsystems)  << ','
+                  << PrintSize(elemsPerSubsys) << ','
+                  << PrintSize(elemSize)       << ','
+                  << PrintSize(churnCount)     << ','
+                  << PrintSize(accessCount)    << ','
+                  << PrintSize(repCount)       << std::endl;
 
     if (verbose) {
         std::cerr << "systemSize     = " << PrintSize(systemSize)     << '\n'
@@ -375,23 +2365,109 @@ int main(int argc, const char *argv[])
                   << "elementSize    = " << PrintSize(elemSize)       << '\n'
                   << "churnCount     = " << PrintSize(churnCount)     << '\n'
                   << "accessCount    = " << PrintSize(accessCount)    << '\n'
-                  << "repCount       = " << PrintSize(repCount)       << '\n';
+                  << "repCount       = " << PrintSize(repCount)       << '\n'
+                  << "numThreads     = " << numThreads                << '\n'
+                  << "resource       = " << resourceName(resourceKind) << '\n'
+                  << "bufferMode     = " << bufferModeName(bufferFlags) << '\n'
+                  << "accessKernel   = " << accessKernelName(accessKernel)
+                  << " (" << vecBytes << "-byte vectors)\n"
+                  << "elementType    = " << elementKindName(elementKind)
+                  << '\n'
+                  << "churnPattern   = " << churnPatternName() << '\n';
     }
 
-    static constexpr int cachelineSize = 64;
+    // Compute total bytes allocated for `n` subsystems.
+    const auto [elemBytes, subsysHeaderBytes] = withElementType([](auto tag) {
+        using E = typename decltype(tag)::type;
+        return std::pair(elementFootprint<E>() + sizeof(E),
+                         sizeof(SubsystemOf<E>));
+    });
+
+    auto partitionBytes = [=](std::size_t n) {
+        std::size_t subsysBytes = elemBytes * elemsPerSubsys;
+        std::size_t totalBytes = (subsysBytes + subsysHeaderBytes) * n;
+        // Pad size with one cache line per subsystem
+        totalBytes += cacheLineSize * n;
+        return totalBytes;
+    };
+
+    // Divide the subsystems as evenly as possible among the threads and
+    // allocate a separate buffer for each thread's allocations.  Only the
+    // default monotonic resource uses a pre-allocated buffer.
+    std::vector<Partition> partitions(numThreads);
+    for (std::size_t t = 0; t < numThreads; ++t) {
+        Partition& part = partitions[t];
+        part.numSubsystems = numSubsystems / numThreads +
+            (t < numSubsystems % numThreads ? 1 : 0);
+        part.bufferBytes = partitionBytes(part.numSubsystems);
+        part.buffer = (ResourceKind::monotonic == resourceKind ?
+                       allocateBuffer(part.bufferBytes) : nullptr);
+        part.spareBuffer = (ResourceKind::monotonic == resourceKind &&
+                            compactInterval > 0 ?
+                            allocateBuffer(part.bufferBytes) : nullptr);
+    }
 
-    // Compute total bytes allocated.
-    std::size_t subsysBytes = (elemSize + sizeof(Element)) * elemsPerSubsys;
-    std::size_t totalBytes = (subsysBytes + sizeof(Subsystem)) * numSubsystems;
-    // Pad size with one cache line per subsystem
-    totalBytes += cachelineSize * numSubsystems;
+    if (countEvents) {
+        // Fall back to timing only if no counters are available at all.
+        // Counters that are individually unavailable are reported as `NA`.
+        PerfCounters probe;
+        if (! probe.anyAvailable()) {
+            std::cerr << "Warning: hardware performance counters are not "
+                "available; reporting times only\n";
+            countEvents = false;
+        }
+        for (int e = 0; e < numPerfEvents; ++e) {
+            eventAvailable[e] = probe.available(PerfEvent(e));
+            if (countEvents && verbose && ! eventAvailable[e])
+                std::cerr << "Counter " << PerfCounters::name(PerfEvent(e))
+                          << " is not available\n";
+        }
+    }
 
-    // Allocate a buffer for all allocations
-    void* buffer = ::operator new(totalBytes);
+    // Run the warmups and repetitions with the arms interleaved.
+    std::vector<Arm> arms{ Arm::copy, Arm::move };
+    if (runRelocate) arms.push_back(Arm::relocate);
+
+    std::vector<std::vector<TestResult>> samples(arms.size());
+    for (std::size_t n = 0; n < warmupCount + repetitions; ++n) {
+        if (showProgress && n == warmupCount && warmupCount > 0)
+            std::cerr << "Warmup finished\n";
+        for (std::size_t a = 0; a < arms.size(); ++a) {
+            TestResult result = runArm(arms[a], partitions);
+            if (n >= warmupCount) samples[a].push_back(std::move(result));
+        }
+    }
 
-    chrono::milliseconds copyMs = doTest<true>(buffer, totalBytes);
-    chrono::milliseconds moveMs = doTest<false>(buffer, totalBytes);
+    TestResult copyResult = summarize(&samples[0]);
+    TestResult moveResult = summarize(&samples[1]);
+
+    std::optional<TestResult> relocateResult;
+    if (runRelocate) relocateResult = summarize(&samples[2]);
+
+    if (measureFootprint) {
+        // Run each arm once more, untimed, to measure its footprint, with a
+        // counting default resource exposing the allocations that bypass the
+        // system's resource.
+        static ThreadCountingResource defaultCounter;
+        std::pmr::memory_resource *savedDefault =
+            std::pmr::set_default_resource(&defaultCounter);
+        footprintPass = true;
+        if (showProgress) std::cerr << "Measuring footprint\n";
+        TestResult* results[] = {
+            &copyResult, &moveResult,
+            relocateResult ? &*relocateResult : nullptr
+        };
+        for (std::size_t a = 0; a < arms.size(); ++a) {
+            results[a]->footprint = runArm(arms[a], partitions).footprint;
+        }
+        footprintPass = false;
+        std::pmr::set_default_resource(savedDefault);
+    }
+    const TestResult *relocate_p = relocateResult ? &*relocateResult : nullptr;
 
-    std::cout << copyMs.count() << std::endl;
-    std::cout << moveMs.count() << std::endl;
+    if (OutputFormat::text == outputFormat)
+        printTextResults(copyResult, moveResult, relocate_p);
+    else
+        printRecord(std::cout,
+                    makeRecord(copyResult, moveResult, relocate_p));
 }
@@ -0,0 +1,211 @@
+#! /usr/bin/python3
+
+# Compare two sets of structured benchmark results and flag regressions.
+#
+# Usage: compare_results.py [ --alpha A ] [ --threshold PCT ]
+#                           [ --metric NAME ]... baseline new
+#
+# `baseline` and `new` are files of records produced by `benchmark -o json`
+# (one JSON object per line, e.g., `results/test.N.jsonl`) or by
+# `benchmark -o csv` (e.g., `results/test.N.csv`).  Records are matched by
+# their parameters (every field other than the results and the `env.*`
+# fields).  Records having the same parameters within a file are treated as
+# repeated samples of the same configuration.
+#
+# For each configuration present in both files, each selected metric (by
+# default, `copy.totalMs`, `move.totalMs`, and `movePct`, plus
+# `relocate.totalMs` and `relocatePct` for runs using `-d`) is compared.  All
+# metrics are times or ratios for which lower is better.  A metric is flagged
+# as a REGRESSION if its mean increased by more than `--threshold` percent
+# (default 5) and Welch's t-test rejects equal means at significance level
+# `--alpha` (default 0.05).  Significance can be tested only when both files
+# have at least two samples of a configuration; otherwise a large change is
+# flagged with `?` but is not counted as a regression.
+#
+# The exit status is 1 if any regression was flagged, 0 otherwise, so that
+# the script can be used to gate library upgrades.
+
+import sys
+import csv
+import json
+import math
+
+defaultMetrics = [ "copy.totalMs", "move.totalMs", "relocate.totalMs",
+                   "movePct", "relocatePct" ]
+
+def userError(errorStr):
+    print(errorStr, file=sys.stderr)
+    sys.exit(2)
+
+def usage(errorStr = None):
+    usageStr = ("Usage: compare_results.py [ --alpha A ] [ --threshold PCT ]"
+                " [ --metric NAME ]... baseline new")
+    if errorStr is None:
+        userError(usageStr)
+    else:
+        userError("Usage error: " + errorStr + '\n' + usageStr)
+
+def isResultField(name):
+    """Return true if the field `name` is a measured result rather than a
+    parameter or a description of the environment"""
+    return ('.' in name and not name.startswith("env.")) or name.endswith("Pct")
+
+def readRecords(filename):
+    """Return a list of dictionaries, one per record in `filename`"""
+    records = [ ]
+    with open(filename) as f:
+        if filename.endswith(".csv"):
+            header = None
+            for row in csv.reader(f):
+                if not row:
+                    continue
+                if header is None or row == header:
+                    header = row   # Header lines may be repeated
+                    continue
+                records.append(dict(zip(header, row)))
+        else:
+            for line in f:
+                line = line.strip()
+                if line:
+                    records.append(json.loads(line))
+    return records
+
+def groupSamples(records):
+    """Return a dictionary mapping each configuration (a tuple of parameter
+    name/value pairs) to a dictionary mapping each result name to its list of
+    samples"""
+    groups = { }
+    for rec in records:
+        # Normalize JSON values (e.g., `false`) to match their CSV spelling
+        key = tuple((k, v if isinstance(v, str) else json.dumps(v))
+                    for k, v in rec.items()
+                    if not isResultField(k) and not k.startswith("env."))
+        samples = groups.setdefault(key, { })
+        for k, v in rec.items():
+            if isResultField(k):
+                try:
+                    samples.setdefault(k, [ ]).append(float(v))
+                except ValueError:
+                    pass   # Not a number (e.g., "NA")
+    return groups
+
+def meanAndVariance(xs):
+    n = len(xs)
+    mean = sum(xs) / n
+    var = sum((x - mean) ** 2 for x in xs) / (n - 1) if n > 1 else 0.0
+    return mean, var
+
+def betaContinuedFraction(a, b, x):
+    """Continued fraction for the regularized incomplete beta function
+    (modified Lentz's method)"""
+    tiny = 1e-300
+    c = 1.0
+    d = 1.0 - (a + b) * x / (a + 1.0)
+    d = 1.0 / (d if abs(d) > tiny else tiny)
+    h = d
+    for m in range(1, 300):
+        m2 = 2 * m
+        for num in (m * (b - m) * x / ((a + m2 - 1.0) * (a + m2)),
+                    -(a + m) * (a + b + m) * x / ((a + m2) * (a + m2 + 1.0))):
+            d = 1.0 + num * d
+            d = 1.0 / (d if abs(d) > tiny else tiny)
+            c = 1.0 + num / c
+            c = c if abs(c) > tiny else tiny
+            h *= d * c
+        if abs(d * c - 1.0) < 1e-12:
+            break
+    return h
+
+def regularizedIncompleteBeta(a, b, x):
+    if x <= 0.0:
+        return 0.0
+    if x >= 1.0:
+        return 1.0
+    lbt = (math.lgamma(a + b) - math.lgamma(a) - math.lgamma(b) +
+           a * math.log(x) + b * math.log(1.0 - x))
+    if x < (a + 1.0) / (a + b + 2.0):
+        return math.exp(lbt) * betaContinuedFraction(a, b, x) / a
+    else:
+        return 1.0 - math.exp(lbt) * betaContinuedFraction(b, a, 1.0 - x) / b
+
+def welchPValue(xs, ys):
+    """Return the two-sided p-value of Welch's t-test for equal means of the
+    samples `xs` and `ys`, or None if either has fewer than two samples"""
+    if len(xs) < 2 or len(ys) < 2:
+        return None
+    mx, vx = meanAndVariance(xs)
+    my, vy = meanAndVariance(ys)
+    sx, sy = vx / len(xs), vy / len(ys)
+    if sx + sy == 0.0:
+        return 0.0 if mx != my else 1.0
+    t = (my - mx) / math.sqrt(sx + sy)
+    df = (sx + sy) ** 2 / (sx ** 2 / (len(xs) - 1) + sy ** 2 / (len(ys) - 1))
+    return regularizedIncompleteBeta(df / 2.0, 0.5, df / (df + t * t))
+
+def formatKey(key):
+    return ",".join(v for k, v in key)
+
+def main(argv):
+    alpha = 0.05
+    threshold = 5.0
+    metrics = [ ]
+    files = [ ]
+
+    args = iter(argv[1:])
+    for arg in args:
+        try:
+            if arg == "--alpha":
+                alpha = float(next(args))
+            elif arg == "--threshold":
+                threshold = float(next(args))
+            elif arg == "--metric":
+                metrics.append(next(args))
+            elif arg.startswith("-"):
+                usage("Unknown option " + arg)
+            else:
+                files.append(arg)
+        except (StopIteration, ValueError):
+            usage("Missing or bad value for " + arg)
+
+    if len(files) != 2:
+        usage()
+    if not metrics:
+        metrics = defaultMetrics
+
+    baseline = groupSamples(readRecords(files[0]))
+    current  = groupSamples(readRecords(files[1]))
+
+    regressions = 0
+    compared = 0
+    print("configuration,metric,baseline,new,change%,p,flag")
+    for key, baseSamples in baseline.items():
+        if key not in current:
+            continue
+        newSamples = current[key]
+        for metric in metrics:
+            xs = baseSamples.get(metric)
+            ys = newSamples.get(metric)
+            if not xs or not ys:
+                continue
+            compared += 1
+            mx, _ = meanAndVariance(xs)
+            my, _ = meanAndVariance(ys)
+            change = 100.0 * (my - mx) / mx if mx != 0 else 0.0
+            p = welchPValue(xs, ys)
+            flag = ""
+            if change > threshold:
+                if p is None:
+                    flag = "?"
+                elif p < alpha:
+                    flag = "REGRESSION"
+                    regressions += 1
+            pStr = "n/a" if p is None else f"{p:.4f}"
+            print(f"{formatKey(key)},{metric},{mx:.3f},{my:.3f},"
+                  f"{change:+.1f},{pStr},{flag}")
+
+    print(f"{compared} comparisons, {regressions} significant regressions",
+          file=sys.stderr)
+    return 1 if regressions else 0
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,142 @@
+// latency_histogram.h                                                -*-C++-*-
+
+#ifndef INCLUDED_LATENCY_HISTOGRAM_DOT_H
+#define INCLUDED_LATENCY_HISTOGRAM_DOT_H
+
+// Histogram of latencies with bounded relative error, in the style of
+// HdrHistogram.  Values below `2^subBucketBits` are recorded exactly; larger
+// values are recorded in one of `2^subBucketBits` linear sub-buckets of the
+// power-of-two range containing them, so that any value read back differs
+// from a recorded value by less than `1 / 2^subBucketBits` (about 3%).
+// Recording is a few shifts and an increment, with no allocation.
+
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+class LatencyHistogram
+{
+  public:
+    static constexpr int subBucketBits = 5;
+
+    // Record one occurrence of the specified latency.
+    void record(std::chrono::nanoseconds latency);
+
+    // Add all the values recorded in `rhs` to this histogram.
+    LatencyHistogram& operator+=(const LatencyHistogram& rhs);
+
+    std::uint64_t count() const { return m_count; }
+
+    // Return the latency at or below which the specified `fraction` of the
+    // recorded values fall, e.g., `percentile(0.99)` for p99, or zero if no
+    // values were recorded.
+    std::chrono::nanoseconds percentile(double fraction) const;
+
+    // Return the largest recorded latency (exact).
+    std::chrono::nanoseconds max() const
+        { return std::chrono::nanoseconds(m_max); }
+
+  private:
+    static constexpr int subBucketCount = 1 << subBucketBits;
+    static constexpr int numBuckets     = (64 - subBucketBits + 1) *
+                                          subBucketCount;
+
+    std::array<std::uint64_t, numBuckets> m_buckets{};
+    std::uint64_t                         m_count = 0;
+    std::uint64_t                         m_max   = 0;
+
+    static int           bucketIndex(std::uint64_t value);
+    static std::uint64_t highestValueIn(int index);
+};
+
+// Guard that records the duration of a scope in a histogram.  A null
+// `LatencyHistogram` pointer makes the guard a no-op that does not read the
+// clock.
+class LatencyScope
+{
+    using Clock = std::chrono::steady_clock;
+
+    LatencyHistogram  *m_histogram_p;
+    Clock::time_point  m_start;
+
+  public:
+    explicit LatencyScope(LatencyHistogram *histogram_p)
+        : m_histogram_p(histogram_p)
+        { if (m_histogram_p) m_start = Clock::now(); }
+
+    ~LatencyScope()
+        { if (m_histogram_p) m_histogram_p->record(Clock::now() - m_start); }
+
+    LatencyScope(const LatencyScope&) = delete;
+    LatencyScope& operator=(const LatencyScope&) = delete;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// INLINE FUNCTION IMPLEMENTATIONS
+///////////////////////////////////////////////////////////////////////////////
+
+inline int LatencyHistogram::bucketIndex(std::uint64_t value)
+{
+    if (value < subBucketCount) return int(value);
+
+    // `value` is in `[2^exp, 2^(exp+1))`, which is divided into
+    // `subBucketCount` sub-buckets of width `2^(exp - subBucketBits)`.
+    const int exp   = std::bit_width(value) - 1;
+    const int shift = exp - subBucketBits;
+    return ((shift + 1) * subBucketCount +
+            int((value >> shift) - subBucketCount));
+}
+
+inline std::uint64_t LatencyHistogram::highestValueIn(int index)
+{
+    if (index < subBucketCount) return std::uint64_t(index);
+
+    const int           shift = index / subBucketCount - 1;
+    const std::uint64_t sub   = std::uint64_t(index % subBucketCount);
+    return ((subBucketCount + sub + 1) << shift) - 1;
+}
+
+inline void LatencyHistogram::record(std::chrono::nanoseconds latency)
+{
+    std::uint64_t value = latency.count() > 0 ? latency.count() : 0;
+    ++m_buckets[bucketIndex(value)];
+    ++m_count;
+    if (value > m_max) m_max = value;
+}
+
+inline LatencyHistogram&
+LatencyHistogram::operator+=(const LatencyHistogram& rhs)
+{
+    for (int i = 0; i < numBuckets; ++i) {
+        m_buckets[i] += rhs.m_buckets[i];
+    }
+    m_count += rhs.m_count;
+    if (rhs.m_max > m_max) m_max = rhs.m_max;
+    return *this;
+}
+
+inline std::chrono::nanoseconds
+LatencyHistogram::percentile(double fraction) const
+{
+    if (0 == m_count) return std::chrono::nanoseconds(0);
+
+    // Rank (1-based) of the value to return.
+    std::uint64_t rank = std::uint64_t(std::ceil(fraction * double(m_count)));
+    if (rank < 1)       rank = 1;
+    if (rank > m_count) rank = m_count;
+
+    std::uint64_t seen = 0;
+    for (int i = 0; i < numBuckets; ++i) {
+        seen += m_buckets[i];
+        if (seen >= rank) {
+            std::uint64_t value = highestValueIn(i);
+            return std::chrono::nanoseconds(value < m_max ? value : m_max);
+        }
+    }
+
+    return max();
+}
+
+#endif // ! defined(INCLUDED_LATENCY_HISTOGRAM_DOT_H)
@@ -0,0 +1,215 @@
+// mmap_resource.h                                                    -*-C++-*-
+
+#ifndef INCLUDED_MMAP_RESOURCE_DOT_H
+#define INCLUDED_MMAP_RESOURCE_DOT_H
+
+// Memory resource that maps each block directly from the operating system
+// with an anonymous `mmap` and returns it with `munmap`.  It is meant as the
+// upstream resource of an arena, such as a `monotonic_buffer_resource` or a
+// pool resource, that asks for few, large chunks: each block occupies a whole
+// number of pages, so small blocks waste most of a page each.
+//
+// With the `hugePages` flag, every block of at least one huge page (2 MiB) is
+// aligned to a huge-page boundary and advised with `MADV_HUGEPAGE`, so that
+// the kernel can back it with transparent huge pages (if
+// `/sys/kernel/mm/transparent_hugepage/enabled` allows it) and a multi-GiB
+// arena needs few TLB entries.  With the `populate` flag, all pages of each
+// block are faulted in when it is allocated (`MAP_POPULATE`, or
+// `MADV_POPULATE_WRITE` with huge pages, since `MAP_POPULATE` would fault in
+// small pages before the advice is given).
+//
+// Alignments larger than a page are satisfied by mapping extra pages and
+// unmapping the unused head and tail, so no memory is wasted.  The resource
+// is thread-safe.  On platforms without `mmap`, blocks are obtained from the
+// aligned `::operator new` and the flags are ignored.
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+
+#ifdef __unix__
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
+
+class MmapResource : public std::pmr::memory_resource
+{
+  public:
+    enum Flags {
+        hugePages = 1,  // Align and advise large blocks for huge pages
+        populate  = 2   // Fault in all pages on allocation
+    };
+
+    static constexpr std::size_t hugePageSize = std::size_t(2) << 20;
+
+    explicit MmapResource(int flags = 0) : m_flags(flags) { }
+
+    MmapResource(const MmapResource&) = delete;
+    MmapResource& operator=(const MmapResource&) = delete;
+
+    int flags() const { return m_flags; }
+
+    // Return the number of bytes currently mapped, and the largest number
+    // mapped at any one time.
+    std::size_t bytesMapped() const
+        { return m_bytesMapped.load(std::memory_order_relaxed); }
+    std::size_t peakBytesMapped() const
+        { return m_peakBytesMapped.load(std::memory_order_relaxed); }
+
+    // Return the number of `madvise` calls that failed, e.g., because the
+    // kernel does not support transparent huge pages.  Such a failure does
+    // not make the allocation fail.
+    std::size_t adviceFailures() const
+        { return m_adviceFailures.load(std::memory_order_relaxed); }
+
+    // Return the `errno` of the most recent failed `madvise` call, or 0.
+    int lastAdviceError() const
+        { return m_lastAdviceError.load(std::memory_order_relaxed); }
+
+  protected:
+    // Call `madvise`.  Overridden by tests to simulate failures.
+    virtual int callMadvise(void* p, std::size_t len, int advice);
+
+  private:
+    int                      m_flags;
+    std::atomic<std::size_t> m_bytesMapped{0};
+    std::atomic<std::size_t> m_peakBytesMapped{0};
+    std::atomic<std::size_t> m_adviceFailures{0};
+    std::atomic<int>         m_lastAdviceError{0};
+
+    static std::size_t pageSize();
+
+    // Return the number of bytes mapped for a block of `bytes` bytes, and the
+    // alignment of such a block for the requested `align`.
+    std::size_t mappedBytes(std::size_t bytes) const;
+    std::size_t blockAlignment(std::size_t bytes, std::size_t align) const;
+
+    void advise(void* p, std::size_t len, int advice);
+
+    void* do_allocate(std::size_t bytes, std::size_t align) override;
+    void do_deallocate(void* p, std::size_t bytes, std::size_t align)
+        override;
+    bool do_is_equal(const memory_resource& other) const noexcept override
+        { return this == &other; }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// INLINE FUNCTION IMPLEMENTATIONS
+///////////////////////////////////////////////////////////////////////////////
+
+inline std::size_t MmapResource::pageSize()
+{
+#ifdef __unix__
+    static const std::size_t size = std::size_t(::sysconf(_SC_PAGESIZE));
+    return size;
+#else
+    return 4096;
+#endif
+}
+
+inline std::size_t MmapResource::mappedBytes(std::size_t bytes) const
+{
+    const std::size_t page = pageSize();
+    return bytes < page ? page : (bytes + page - 1) & ~(page - 1);
+}
+
+inline std::size_t
+MmapResource::blockAlignment(std::size_t bytes, std::size_t align) const
+{
+    if ((m_flags & hugePages) && bytes >= hugePageSize && align < hugePageSize)
+        return hugePageSize;
+    return align < pageSize() ? pageSize() : align;
+}
+
+inline int MmapResource::callMadvise(void* p, std::size_t len, int advice)
+{
+#ifdef __unix__
+    return ::madvise(p, len, advice);
+#else
+    (void) p; (void) len; (void) advice;
+    return 0;
+#endif
+}
+
+inline void MmapResource::advise(void* p, std::size_t len, int advice)
+{
+    if (0 != callMadvise(p, len, advice)) {
+        m_lastAdviceError.store(errno, std::memory_order_relaxed);
+        m_adviceFailures.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+inline void* MmapResource::do_allocate(std::size_t bytes, std::size_t align)
+{
+    const std::size_t len       = mappedBytes(bytes);
+    const std::size_t alignment = blockAlignment(bytes, align);
+
+#ifdef __unix__
+    // Map enough extra pages that an aligned block fits, then unmap the
+    // unused head and tail.
+    const std::size_t extra = alignment - pageSize();
+    int mmapFlags = MAP_PRIVATE | MAP_ANONYMOUS;
+# ifdef MAP_POPULATE
+    if ((m_flags & populate) && ! (m_flags & hugePages) && 0 == extra)
+        mmapFlags |= MAP_POPULATE;
+# endif
+    void* region = ::mmap(nullptr, len + extra, PROT_READ | PROT_WRITE,
+                          mmapFlags, -1, 0);
+    if (MAP_FAILED == region)
+        throw std::bad_alloc();
+
+    char* const begin = static_cast<char*>(region);
+    char* const block = reinterpret_cast<char*>(
+        (reinterpret_cast<std::uintptr_t>(begin) + alignment - 1) &
+        ~std::uintptr_t(alignment - 1));
+    if (block != begin)
+        ::munmap(begin, block - begin);
+    if (block + len != begin + len + extra)
+        ::munmap(block + len, begin + extra - block);
+
+# ifdef MADV_HUGEPAGE
+    if ((m_flags & hugePages) && len >= hugePageSize)
+        advise(block, len, MADV_HUGEPAGE);
+# endif
+    if ((m_flags & populate) && ! (mmapFlags & MAP_POPULATE)) {
+# ifdef MADV_POPULATE_WRITE
+        if (0 != callMadvise(block, len, MADV_POPULATE_WRITE))
+# endif
+        {
+            volatile char* page = block;
+            for (std::size_t offset = 0; offset < len; offset += pageSize())
+                page[offset] = 0;
+        }
+    }
+#else
+    void* block = ::operator new(len, std::align_val_t(alignment));
+#endif
+
+    const std::size_t mapped =
+        m_bytesMapped.fetch_add(len, std::memory_order_relaxed) + len;
+    std::size_t peak = m_peakBytesMapped.load(std::memory_order_relaxed);
+    while (mapped > peak &&
+           ! m_peakBytesMapped.compare_exchange_weak(
+                 peak, mapped, std::memory_order_relaxed)) {
+    }
+
+    return block;
+}
+
+inline void
+MmapResource::do_deallocate(void* p, std::size_t bytes, std::size_t align)
+{
+    const std::size_t len = mappedBytes(bytes);
+#ifdef __unix__
+    (void) align;
+    ::munmap(p, len);
+#else
+    ::operator delete(p, len, std::align_val_t(blockAlignment(bytes, align)));
+#endif
+    m_bytesMapped.fetch_sub(len, std::memory_order_relaxed);
+}
+
+#endif // ! defined(INCLUDED_MMAP_RESOURCE_DOT_H)
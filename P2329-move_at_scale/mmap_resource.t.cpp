@@ -0,0 +1,215 @@
+// mmap_resource.t.cpp                                                -*-C++-*-
+
+#include "mmap_resource.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+//==========================================================================
+//                  ASSERT TEST MACRO
+//--------------------------------------------------------------------------
+static int testStatus = 0;
+
+static void aSsErT(int c, const char *s, int i) {
+    if (c) {
+        std::cout << __FILE__ << ":" << i << ": error: " << s
+                  << "    (failed)" << std::endl;
+        if (testStatus >= 0 && testStatus <= 100) ++testStatus;
+    }
+}
+
+# define TEST_ASSERT(X) { aSsErT(!(X), #X, __LINE__); }
+
+//=============================================================================
+//                  CLASSES AND FUNCTIONS FOR TESTING
+//-----------------------------------------------------------------------------
+
+// `MmapResource` whose `madvise` calls with the advice `d_failAdvice` fail
+// with `EINVAL`, as on a kernel that does not support that advice.
+class FailingMmapResource : public MmapResource
+{
+  public:
+    int         d_failAdvice = -1;
+    std::size_t d_calls      = 0;
+
+    explicit FailingMmapResource(int flags) : MmapResource(flags) { }
+
+  protected:
+    int callMadvise(void* p, std::size_t len, int advice) override {
+        ++d_calls;
+        if (advice == d_failAdvice) {
+            errno = EINVAL;
+            return -1;
+        }
+        return MmapResource::callMadvise(p, len, advice);
+    }
+};
+
+// Return the virtual memory size of this process in KiB, read without
+// allocating so that the heap does not change it.
+static long vmSizeKiB()
+{
+    char buffer[4096];
+    int  fd = ::open("/proc/self/status", O_RDONLY);
+    if (fd < 0) return -1;
+    ssize_t n = ::read(fd, buffer, sizeof(buffer) - 1);
+    ::close(fd);
+    if (n <= 0) return -1;
+    buffer[n] = '\0';
+    const char *line = std::strstr(buffer, "VmSize:");
+    return line ? std::strtol(line + 7, nullptr, 10) : -1;
+}
+
+// Return true if all pages of `[p, p + len)` are resident.
+static bool isResident(void* p, std::size_t len)
+{
+    const std::size_t page  = std::size_t(::sysconf(_SC_PAGESIZE));
+    const std::size_t pages = (len + page - 1) / page;
+    unsigned char     vec[1024];
+    if (pages > sizeof(vec) || 0 != ::mincore(p, len, vec)) return false;
+    for (std::size_t i = 0; i < pages; ++i) {
+        if (! (vec[i] & 1)) return false;
+    }
+    return true;
+}
+
+static bool isAligned(void* p, std::size_t alignment)
+{
+    return 0 == reinterpret_cast<std::uintptr_t>(p) % alignment;
+}
+
+//=============================================================================
+//                              MAIN PROGRAM
+//-----------------------------------------------------------------------------
+
+int main()
+{
+    const std::size_t page = std::size_t(::sysconf(_SC_PAGESIZE));
+
+    {
+        // Sizes are rounded up to whole pages, and blocks are page aligned.
+
+        MmapResource rsrc;
+        TEST_ASSERT(0 == rsrc.flags());
+
+        void* p = rsrc.allocate(1, 1);
+        TEST_ASSERT(isAligned(p, page));
+        TEST_ASSERT(page == rsrc.bytesMapped());
+        static_cast<char*>(p)[page - 1] = 1;
+
+        void* q = rsrc.allocate(page + 1, 8);
+        TEST_ASSERT(3 * page == rsrc.bytesMapped());
+        TEST_ASSERT(3 * page == rsrc.peakBytesMapped());
+
+        rsrc.deallocate(p, 1, 1);
+        rsrc.deallocate(q, page + 1, 8);
+        TEST_ASSERT(0 == rsrc.bytesMapped());
+        TEST_ASSERT(3 * page == rsrc.peakBytesMapped());
+        TEST_ASSERT(0 == rsrc.adviceFailures());
+        TEST_ASSERT(0 == rsrc.lastAdviceError());
+    }
+
+    {
+        // Alignments larger than a page: the unused head and tail of the
+        // mapping are unmapped, so the process grows by the block alone,
+        // and deallocation unmaps the rest.
+
+        MmapResource rsrc;
+        const std::size_t alignment = 256 * page;
+        const std::size_t len       = 3 * page;
+
+        const long before = vmSizeKiB();
+        void* p = rsrc.allocate(len, alignment);
+        const long during = vmSizeKiB();
+        TEST_ASSERT(isAligned(p, alignment));
+        TEST_ASSERT(long(len / 1024) == during - before);
+        static_cast<char*>(p)[len - 1] = 1;
+
+        rsrc.deallocate(p, len, alignment);
+        TEST_ASSERT(before == vmSizeKiB());
+        TEST_ASSERT(0 == rsrc.bytesMapped());
+    }
+
+    {
+        // Huge pages: large blocks are aligned to a huge page whatever the
+        // requested alignment; small blocks are not advised.
+
+        FailingMmapResource rsrc(MmapResource::hugePages);
+        const std::size_t len = 2 * MmapResource::hugePageSize;
+
+        const long before = vmSizeKiB();
+        void* p = rsrc.allocate(len, 8);
+        TEST_ASSERT(isAligned(p, MmapResource::hugePageSize));
+        TEST_ASSERT(long(len / 1024) == vmSizeKiB() - before);
+        TEST_ASSERT(1 == rsrc.d_calls);
+
+        void* small = rsrc.allocate(page, 8);
+        TEST_ASSERT(1 == rsrc.d_calls);
+
+        rsrc.deallocate(small, page, 8);
+        rsrc.deallocate(p, len, 8);
+        TEST_ASSERT(before == vmSizeKiB());
+    }
+
+    {
+        // A failed `MADV_HUGEPAGE` is counted, its `errno` kept, and the
+        // block still returned.
+
+        FailingMmapResource rsrc(MmapResource::hugePages);
+        rsrc.d_failAdvice = MADV_HUGEPAGE;
+        const std::size_t len = MmapResource::hugePageSize;
+
+        void* p = rsrc.allocate(len, 8);
+        TEST_ASSERT(nullptr != p);
+        TEST_ASSERT(1 == rsrc.adviceFailures());
+        TEST_ASSERT(EINVAL == rsrc.lastAdviceError());
+        static_cast<char*>(p)[len - 1] = 1;
+        rsrc.deallocate(p, len, 8);
+    }
+
+    {
+        // Populate: without huge pages, `MAP_POPULATE` faults the pages in
+        // and `madvise` is not called.
+
+        FailingMmapResource rsrc(MmapResource::populate);
+        const std::size_t len = 16 * page;
+
+        void* p = rsrc.allocate(len, 8);
+        TEST_ASSERT(isResident(p, len));
+        TEST_ASSERT(0 == rsrc.d_calls);
+        rsrc.deallocate(p, len, 8);
+
+        // With an alignment larger than a page, `MAP_POPULATE` is not used.
+        p = rsrc.allocate(len, 16 * page);
+        TEST_ASSERT(isAligned(p, 16 * page));
+        TEST_ASSERT(isResident(p, len));
+        rsrc.deallocate(p, len, 16 * page);
+    }
+
+#ifdef MADV_POPULATE_WRITE
+    {
+        // If `MADV_POPULATE_WRITE` fails, as on kernels before 5.14, the
+        // pages are touched instead.  That is not an advice failure.
+
+        FailingMmapResource rsrc(MmapResource::hugePages |
+                                 MmapResource::populate);
+        rsrc.d_failAdvice = MADV_POPULATE_WRITE;
+        const std::size_t len = MmapResource::hugePageSize;
+
+        void* p = rsrc.allocate(len, 8);
+        TEST_ASSERT(isResident(p, len));
+        TEST_ASSERT(2 == rsrc.d_calls);
+        TEST_ASSERT(0 == rsrc.adviceFailures());
+        rsrc.deallocate(p, len, 8);
+    }
+#endif
+
+    return testStatus;
+}
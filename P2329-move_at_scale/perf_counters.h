@@ -0,0 +1,191 @@
+// perf_counters.h                                                    -*-C++-*-
+
+#ifndef INCLUDED_PERF_COUNTERS_DOT_H
+#define INCLUDED_PERF_COUNTERS_DOT_H
+
+// Hardware performance counters for the calling thread, read through the Linux
+// `perf_event_open` system call.  On other platforms, or when the kernel does
+// not permit access to a counter (e.g., `perf_event_paranoid` is too high or
+// the machine is virtualized without a PMU), that counter is simply reported
+// as unavailable and reads as zero.
+
+#include <array>
+#include <cstdint>
+
+#ifdef __linux__
+# include <linux/perf_event.h>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+enum PerfEvent {
+    l1dMisses,     // L1 data-cache read misses
+    llcMisses,     // Last-level cache read misses
+    dtlbMisses,    // Data TLB read misses
+    instructions,  // Retired instructions
+    cycles,        // CPU cycles
+    numPerfEvents
+};
+
+class PerfCounters
+{
+  public:
+    using Values = std::array<std::uint64_t, numPerfEvents>;
+
+    // Open all counters for the calling thread. The counters count only while
+    // the thread runs in user mode.
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available(PerfEvent e) const { return m_fds[e] >= 0; }
+    bool anyAvailable() const;
+
+    // Take a snapshot of the counters.
+    void start();
+
+    // Add the change in each counter since the last call to `start` to the
+    // corresponding element of `*acc`.  If a counter was multiplexed with
+    // other counters, its value is scaled by the fraction of time it was
+    // actually counting.
+    void stop(Values* acc);
+
+    static const char* name(PerfEvent e);
+
+  private:
+    struct Reading
+    {
+        std::uint64_t value;
+        std::uint64_t timeEnabled;
+        std::uint64_t timeRunning;
+    };
+
+    int                                m_fds[numPerfEvents];
+    std::array<Reading, numPerfEvents> m_start;
+
+    bool read(PerfEvent e, Reading* r) const;
+};
+
+// Guard that accumulates the counts for the duration of a scope.  A null
+// `PerfCounters` pointer makes the guard a no-op.
+class PerfScope
+{
+    PerfCounters         *m_counters_p;
+    PerfCounters::Values *m_acc_p;
+
+  public:
+    PerfScope(PerfCounters *counters_p, PerfCounters::Values *acc_p)
+        : m_counters_p(counters_p), m_acc_p(acc_p)
+        { if (m_counters_p) m_counters_p->start(); }
+
+    ~PerfScope() { if (m_counters_p) m_counters_p->stop(m_acc_p); }
+
+    PerfScope(const PerfScope&) = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// INLINE FUNCTION IMPLEMENTATIONS
+///////////////////////////////////////////////////////////////////////////////
+
+inline const char* PerfCounters::name(PerfEvent e)
+{
+    static const char* const names[numPerfEvents] = {
+        "l1dMiss", "llcMiss", "dtlbMiss", "instr", "cycles"
+    };
+    return names[e];
+}
+
+#ifdef __linux__
+
+inline PerfCounters::PerfCounters() : m_start{}
+{
+    constexpr std::uint64_t readMiss =
+        (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+    static const struct { std::uint32_t type; std::uint64_t config; }
+        events[numPerfEvents] = {
+            { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D  | readMiss },
+            { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL   | readMiss },
+            { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | readMiss },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS           },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES             }
+        };
+
+    for (int e = 0; e < numPerfEvents; ++e) {
+        perf_event_attr attr{};
+        attr.size           = sizeof(attr);
+        attr.type           = events[e].type;
+        attr.config         = events[e].config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        attr.read_format    = (PERF_FORMAT_TOTAL_TIME_ENABLED |
+                               PERF_FORMAT_TOTAL_TIME_RUNNING);
+
+        // Count for the calling thread on any CPU.
+        m_fds[e] = int(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+}
+
+inline PerfCounters::~PerfCounters()
+{
+    for (int fd : m_fds) {
+        if (fd >= 0) ::close(fd);
+    }
+}
+
+inline bool PerfCounters::read(PerfEvent e, Reading* r) const
+{
+    return (m_fds[e] >= 0 &&
+            sizeof(*r) == ::read(m_fds[e], r, sizeof(*r)));
+}
+
+#else // ! defined(__linux__)
+
+inline PerfCounters::PerfCounters() : m_start{}
+{
+    for (int& fd : m_fds) fd = -1;
+}
+
+inline PerfCounters::~PerfCounters() { }
+
+inline bool PerfCounters::read(PerfEvent, Reading*) const { return false; }
+
+#endif // ! defined(__linux__)
+
+inline bool PerfCounters::anyAvailable() const
+{
+    for (int fd : m_fds) {
+        if (fd >= 0) return true;
+    }
+    return false;
+}
+
+inline void PerfCounters::start()
+{
+    for (int e = 0; e < numPerfEvents; ++e) {
+        read(PerfEvent(e), &m_start[e]);
+    }
+}
+
+inline void PerfCounters::stop(Values* acc)
+{
+    for (int e = 0; e < numPerfEvents; ++e) {
+        Reading now;
+        if (! read(PerfEvent(e), &now)) continue;
+
+        std::uint64_t value   = now.value       - m_start[e].value;
+        std::uint64_t enabled = now.timeEnabled - m_start[e].timeEnabled;
+        std::uint64_t running = now.timeRunning - m_start[e].timeRunning;
+        if (running > 0 && running < enabled)
+            value = std::uint64_t(double(value) * enabled / running);
+
+        (*acc)[e] += value;
+    }
+}
+
+#endif // ! defined(INCLUDED_PERF_COUNTERS_DOT_H)
@@ -0,0 +1,272 @@
+#! /usr/bin/python3
+
+# Run the configurations of one or more `runtest` tests concurrently, each
+# pinned to its own CPU(s), and merge the results into a single CSV file.
+#
+# Usage: sweep.py [ --jobs N ] [ --cpus LIST ] [ --exclusive-bytes SIZE ]
+#                 [ --output FILE ] [ --resume ] test... [ -option... ]
+#
+# The configurations of each `test` (e.g., 1, 2, or 3) are those that
+# `runtest` would run; they are obtained with `runtest --list`.  Options
+# starting with a single `-` (e.g., `-t2` or `-n5`) are passed to the
+# benchmark, as with `runtest`, and must be written without a space.  Each
+# configuration is run with `-ocsv` and its record is appended, preceded by a
+# `test` column, to the output file (default `results/sweep.csv`).
+#
+# Up to `--jobs` configurations (default: the number of CPUs in `--cpus`) run
+# at the same time.  Each is pinned with `sched_setaffinity` to as many CPUs
+# from `--cpus` (default: all CPUs this process may use, e.g., `0-7,16`) as it
+# has threads (`-tN`), so that concurrent runs do not migrate onto each
+# other's cores.  Runs whose system size exceeds `--exclusive-bytes` (default:
+# the size of the last-level cache) are memory bound and would interfere with
+# each other through the shared cache and memory bandwidth, so such a run
+# starts only when nothing else is running, and nothing else starts until it
+# finishes.
+#
+# Each completed configuration is recorded in `FILE.done`.  With `--resume`,
+# configurations already recorded there are skipped and new results are
+# appended to the output; otherwise, both files are started afresh.  A failed
+# run is reported and not recorded, so that resuming retries it.
+
+import sys
+import os
+import re
+import time
+import subprocess
+import tempfile
+
+scriptDir = os.path.dirname(os.path.abspath(__file__))
+runtest   = os.path.join(scriptDir, "runtest")
+benchmark = os.path.join(scriptDir, "obj", "benchmark")
+
+# Benchmark options that take a value (see `processOptions` in benchmark.cpp)
+valueOptions = "twnrmeksoz"
+
+def userError(errorStr):
+    print(errorStr, file=sys.stderr)
+    sys.exit(2)
+
+def usage(errorStr = None):
+    usageStr = ("Usage: sweep.py [ --jobs N ] [ --cpus LIST ]"
+                " [ --exclusive-bytes SIZE ] [ --output FILE ] [ --resume ]"
+                " test... [ -option... ]")
+    if errorStr is None:
+        userError(usageStr)
+    else:
+        userError("Usage error: " + errorStr + '\n' + usageStr)
+
+def parseSize(sizeStr):
+    """Return the value of `sizeStr`, which is a number with an optional K, M,
+    or G suffix, or a power of two written as `2^N`, as does `parseSize` in
+    benchmark.cpp"""
+    m = re.fullmatch(r"(\d+)\^(\d+)", sizeStr)
+    if m:
+        return int(m.group(1)) ** int(m.group(2))
+    m = re.fullmatch(r"(\d+)([KkMmGg]?)", sizeStr)
+    if not m:
+        raise ValueError("bad size " + sizeStr)
+    scale = { "": 1, "k": 2**10, "m": 2**20, "g": 2**30 }
+    return int(m.group(1)) * scale[m.group(2).lower()]
+
+def parseCpuList(listStr):
+    """Return the list of CPUs in `listStr`, e.g., `0-3,8`"""
+    cpus = [ ]
+    for part in listStr.split(","):
+        lo, _, hi = part.partition("-")
+        cpus.extend(range(int(lo), int(hi or lo) + 1))
+    return cpus
+
+def lastLevelCacheBytes():
+    """Return the size of the largest cache of CPU 0, or 32MiB if unknown"""
+    largest = 0
+    cacheDir = "/sys/devices/system/cpu/cpu0/cache"
+    try:
+        for index in os.listdir(cacheDir):
+            with open(os.path.join(cacheDir, index, "size")) as f:
+                largest = max(largest, parseSize(f.read().strip()))
+    except (OSError, ValueError):
+        pass
+    return largest or 32 * 2**20
+
+def describe(args):
+    """Return the system size (None if not given) and the number of threads
+    used by the benchmark when run with `args`"""
+    positional = [ ]
+    threads = 1
+    i = 0
+    while i < len(args):
+        arg = args[i]
+        if arg.startswith("-"):
+            for j in range(1, len(arg)):
+                if arg[j] in valueOptions:
+                    value = arg[j+1:]
+                    if not value and i + 1 < len(args):
+                        i += 1
+                        value = args[i]
+                    if arg[j] == "t":
+                        threads = parseSize(value)
+                    break
+        else:
+            positional.append(arg)
+        i += 1
+    systemSize = None
+    if positional and positional[0] != ".":
+        systemSize = parseSize(positional[0])
+    return systemSize, threads
+
+def doneKey(test, args):
+    """Return the line recording that configuration `args` of `test` is done"""
+    return f"{test} {' '.join(args)}"
+
+def listConfigurations(tests, options):
+    """Return a list of (test, args) pairs, one per configuration"""
+    configs = [ ]
+    for test in tests:
+        out = subprocess.run([ runtest, "--list" ] + options + [ test ],
+                             check=True, capture_output=True, text=True)
+        for line in out.stdout.splitlines():
+            if line.strip():
+                configs.append((test, line.split()))
+    return configs
+
+class Job:
+    def __init__(self, test, args, cpus):
+        self.test = test
+        self.args = args
+        self.cpus = cpus
+        # The output goes to a file rather than a pipe, which is read only
+        # after the run finishes and so could fill up and block the run.
+        self.output = tempfile.TemporaryFile(mode="w+")
+        self.proc = subprocess.Popen(
+            [ benchmark ] + args + [ "-ocsv" ],
+            stdout=self.output, text=True,
+            preexec_fn=lambda: os.sched_setaffinity(0, cpus))
+
+    def lines(self):
+        """Return the lines of output of the finished run"""
+        self.output.seek(0)
+        lines = self.output.read().splitlines()
+        self.output.close()
+        return lines
+
+def main(argv):
+    jobs = None
+    cpus = sorted(os.sched_getaffinity(0))
+    exclusiveBytes = None
+    output = os.path.join(scriptDir, "results", "sweep.csv")
+    resume = False
+    tests = [ ]
+    options = [ ]
+
+    args = iter(argv[1:])
+    for arg in args:
+        try:
+            if arg == "--jobs":
+                jobs = int(next(args))
+            elif arg == "--cpus":
+                cpus = parseCpuList(next(args))
+            elif arg == "--exclusive-bytes":
+                exclusiveBytes = parseSize(next(args))
+            elif arg == "--output":
+                output = next(args)
+            elif arg == "--resume":
+                resume = True
+            elif arg.startswith("--"):
+                usage("Unknown option " + arg)
+            elif arg.startswith("-"):
+                options.append(arg)
+            else:
+                tests.append(arg)
+        except (StopIteration, ValueError):
+            usage("Missing or bad value for " + arg)
+
+    if not tests:
+        usage()
+    if any(opt.startswith("-o") for opt in options):
+        usage("The output format is always CSV")
+    if jobs is None:
+        jobs = len(cpus)
+    if exclusiveBytes is None:
+        exclusiveBytes = lastLevelCacheBytes()
+
+    doneFile = output + ".done"
+    done = set()
+    if resume and os.path.exists(doneFile):
+        with open(doneFile) as f:
+            done = set(line.strip() for line in f)
+    elif os.path.exists(output):
+        os.replace(output, output + ".old")
+    if not resume and os.path.exists(doneFile):
+        os.remove(doneFile)
+
+    pending = [ (test, a) for test, a in listConfigurations(tests, options)
+                if doneKey(test, a) not in done ]
+    print(f"{len(pending)} configurations to run ({len(done)} already done)"
+          f" on CPUs {','.join(map(str, cpus))}", file=sys.stderr)
+
+    haveHeader = os.path.exists(output) and os.path.getsize(output) > 0
+    freeCpus = list(cpus)
+    running = [ ]
+    exclusive = False   # True while an exclusive job is running
+    failures = 0
+
+    with open(output, "a") as out, open(doneFile, "a") as doneOut:
+
+        def reap(block):
+            """Collect the results of finished jobs, waiting for at least one
+            to finish if `block` is true"""
+            nonlocal haveHeader, exclusive, failures
+            while True:
+                finished = [ job for job in running
+                             if job.proc.poll() is not None ]
+                if finished or not block or not running:
+                    break
+                time.sleep(0.05)
+            for job in finished:
+                running.remove(job)
+                freeCpus.extend(job.cpus)
+                exclusive = False
+                lines = job.lines()
+                if job.proc.returncode != 0 or len(lines) < 2:
+                    print("Failed: benchmark " + " ".join(job.args),
+                          file=sys.stderr)
+                    failures += 1
+                    continue
+                if not haveHeader:
+                    print("test," + lines[0], file=out)
+                    haveHeader = True
+                for line in lines[1:]:
+                    print(job.test + "," + line, file=out)
+                out.flush()
+                print(doneKey(job.test, job.args), file=doneOut)
+                doneOut.flush()
+
+        for test, a in pending:
+            systemSize, threads = describe(a)
+            if threads > len(cpus):
+                print("Skipped (too many threads): benchmark " + " ".join(a),
+                      file=sys.stderr)
+                failures += 1
+                continue
+            memoryBound = systemSize is None or systemSize > exclusiveBytes
+
+            # Wait until this job may start.
+            while (exclusive or len(running) >= jobs or
+                   len(freeCpus) < threads or (memoryBound and running)):
+                reap(block=True)
+
+            freeCpus.sort()
+            jobCpus = freeCpus[:threads]
+            del freeCpus[:threads]
+            running.append(Job(test, a, jobCpus))
+            exclusive = memoryBound
+            reap(block=False)
+
+        while running:
+            reap(block=True)
+
+    print(f"Results in {output}; {failures} failed", file=sys.stderr)
+    return 1 if failures else 0
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -105,6 +105,36 @@ _DEFAULT_FUNC_TMPLT(select_on_container_copy_construction,return,{
         return v;
     })
 
+// Allocate 'count' single objects, one at a time, storing the pointers in
+// 'out'.  If an allocation throws, the objects already allocated are
+// deallocated before the exception is rethrown.
+template <typename _Alloc, typename _Size, typename _Ptr>
+void __allocate_each(_Alloc& a, _Size count, _Ptr* out)
+{
+    _Size i = 0;
+    try {
+        for (; i < count; ++i)
+            out[i] = a.allocate(1);
+    }
+    catch (...) {
+        while (i > 0) {
+            --i;
+            a.deallocate(out[i], 1);
+        }
+        throw;
+    }
+}
+
+template <typename _Alloc, typename _Ptr, typename _Size>
+void __deallocate_each(_Alloc& a, _Ptr const* ps, _Size count)
+{
+    for (_Size i = 0; i < count; ++i)
+        a.deallocate(ps[i], 1);
+}
+
+_DEFAULT_FUNC_TMPLT(allocate_n,,{ __allocate_each(v, a1, args...); })
+_DEFAULT_FUNC_TMPLT(deallocate_n,,{ __deallocate_each(v, a1, args...); })
+
 } // end namespace __details
 
 template<typename _Tp, typename _Alloc>
@@ -163,6 +193,21 @@ struct allocator_traits
     static void deallocate(Alloc& a, pointer p, size_type n)
         { a.deallocate(p, n); }
 
+    // Allocate 'count' separate objects, storing pointers to them in
+    // 'out[0]' through 'out[count - 1]'.  Each object can be deallocated
+    // individually with 'deallocate(a, p, 1)' or as part of a batch with
+    // 'deallocate_n'.  Uses 'a.allocate_n(count, out)' if present, otherwise
+    // calls 'a.allocate(1)' 'count' times.
+    static void allocate_n(Alloc& a, size_type count, pointer* out)
+        { _DEFAULT_FUNC(allocate_n,void)(a, count, out); }
+
+    // Deallocate the 'count' objects pointed to by 'ps[0]' through
+    // 'ps[count - 1]', each of which was allocated with 'allocate(a, 1)' or
+    // 'allocate_n'.  Uses 'a.deallocate_n(ps, count)' if present, otherwise
+    // calls 'a.deallocate(ps[i], 1)' for each object.
+    static void deallocate_n(Alloc& a, const pointer* ps, size_type count)
+        { _DEFAULT_FUNC(deallocate_n,void)(a, ps, count); }
+
     template <typename T, typename... Args>
     static void construct(Alloc& a, T* p, Args&&... args) {
         _DEFAULT_FUNC(construct,void)(a, p, std::forward<Args>(args)...);
@@ -0,0 +1,400 @@
+/* mapped_file_allocator.h                  -*-C++-*-
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ *    (See accompanying file LICENSE_1_0.txt or copy at
+ *          http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+/* This component defines 'mapped_file', which maps a file into memory with
+ * 'MAP_SHARED' and manages the mapped region as a heap, and
+ * 'mapped_file_allocator<T>', an allocator that obtains memory from that
+ * heap and whose 'pointer' type is 'offset_ptr<T>'.  A container that lives
+ * in the file and uses a 'mapped_file_allocator' has no absolute addresses
+ * in its representation, so when the file is mapped again, by a later run of
+ * the same program, the container can be used as it is, at whatever address
+ * the file is mapped, without being rebuilt:
+ *
+ *     typedef xstd::list<int, xstd::mapped_file_allocator<int> > List;
+ *
+ *     xstd::mapped_file file("index.dat", 1 << 20);
+ *     List *lst = file.root<List>();
+ *     if (! lst)  // New file
+ *         lst = file.construct_root<List>(file.get_allocator<int>());
+ *     lst->push_back(int(lst->size()));  // One more element on every run
+ *
+ * The file begins with a header that holds the state of the heap and an
+ * offset pointer to a "root" object, through which a program finds the data
+ * it stored.  The heap hands out blocks in power-of-two size classes, from a
+ * free list for each class or else from the unused end of the file, and
+ * never gives memory back to the file.  The size of the file is fixed when
+ * it is created; an allocation that does not fit throws 'std::bad_alloc'.
+ *
+ * The types stored in the file must themselves hold no raw pointers, and
+ * their layout must not change between the programs that map the file.
+ * Neither the heap nor the root is thread-safe, and nothing makes updates
+ * atomic with respect to a crash: a program that warm-starts from a mapped
+ * file should build the file under a temporary name, 'sync' it, and rename
+ * it into place.
+ */
+
+#ifndef INCLUDED_MAPPED_FILE_ALLOCATOR_DOT_H
+#define INCLUDED_MAPPED_FILE_ALLOCATOR_DOT_H
+
+#include <xstd.h>
+#include <offset_ptr.h>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+BEGIN_NAMESPACE_XSTD
+
+namespace __details {
+
+    struct __mapped_free_block
+    {
+        offset_ptr<__mapped_free_block> _M_next;
+    };
+
+    // The header at the start of a mapped file.  All of its state is
+    // position independent.
+    class __mapped_file_header
+    {
+    public:
+        enum {
+            __min_block_size = 16,
+            __max_alignment  = 4096,  // Alignment of the mapping
+            __num_classes    = 48
+        };
+
+        static const std::uint64_t __magic = 0x31504d4644545358ull;
+            // "XSTDFMP1" in little-endian byte order
+
+        explicit __mapped_file_header(std::size_t __size);
+
+        // Return true if the header at the start of a file of '__size' bytes
+        // was written by this version of the component.
+        bool __is_valid(std::size_t __size) const;
+
+        void* __allocate(std::size_t __bytes, std::size_t __alignment);
+        void __deallocate(void* __p, std::size_t __bytes,
+                          std::size_t __alignment) noexcept;
+
+        std::size_t __bytes_unused() const { return _M_size - _M_top; }
+
+        offset_ptr<void>&       __root()       { return _M_root; }
+        const offset_ptr<void>& __root() const { return _M_root; }
+
+    private:
+        std::uint64_t    _M_magic;
+        std::uint64_t    _M_size;  // Size of the file
+        std::uint64_t    _M_top;   // Offset of the first byte never allocated
+        offset_ptr<void> _M_root;
+        offset_ptr<__mapped_free_block> _M_free[__num_classes];
+
+        // Return the size class for a block of '__bytes' bytes aligned to
+        // '__alignment', or '__num_classes' if there is none.
+        static int __size_class(std::size_t __bytes, std::size_t __alignment);
+    };
+
+} // end namespace __details
+
+template <typename _Tp> class mapped_file_allocator;
+
+class mapped_file
+{
+    int                             _M_fd;
+    void*                           _M_base;
+    std::size_t                     _M_size;
+    bool                            _M_created;
+    __details::__mapped_file_header* _M_header;
+
+public:
+    // Map the file at '__path'.  If the file does not exist or is empty, it
+    // is created with a size of '__size' bytes and an empty heap; otherwise
+    // '__size' is ignored, and the file must have been created by a
+    // 'mapped_file'.  Throw 'std::system_error' if the file cannot be opened,
+    // sized, or mapped, and 'std::runtime_error' if it is not a valid mapped
+    // file.
+    mapped_file(const char* __path, std::size_t __size);
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    // Unmap the file.  Objects in the file are not destroyed.
+    ~mapped_file();
+
+    void* data() const { return _M_base; }
+    std::size_t size() const { return _M_size; }
+
+    // Return true if the file was created, rather than opened, by this
+    // object.
+    bool created() const { return _M_created; }
+
+    // Return the number of bytes at the end of the file that have never
+    // been allocated.
+    std::size_t bytes_unused() const { return _M_header->__bytes_unused(); }
+
+    // Write modified pages to the file, and wait for the write to finish.
+    void sync();
+
+    template <typename _Tp>
+    mapped_file_allocator<_Tp> get_allocator() const
+        { return mapped_file_allocator<_Tp>(*this); }
+
+    // Return the root object, or null if the file has none.  '_Tp' must be
+    // the type of the object passed to 'construct_root'.
+    template <typename _Tp>
+    _Tp* root() const
+        { return static_cast<_Tp*>(_M_header->__root().get()); }
+
+    // Construct a '_Tp' in the file from '__args', and make it the root
+    // object, replacing (but not destroying) any previous root.
+    template <typename _Tp, typename... _Args>
+    _Tp* construct_root(_Args&&... __args);
+
+    // Destroy the root object, which must be a '_Tp', and free its memory.
+    template <typename _Tp>
+    void destroy_root();
+
+    template <typename _Tp> friend class mapped_file_allocator;
+};
+
+template <typename _Tp>
+class mapped_file_allocator
+{
+    template <typename _U> friend class mapped_file_allocator;
+
+    // An offset pointer, so that an allocator stored in the file, e.g., in a
+    // container, remains valid when the file is mapped at another address.
+    offset_ptr<__details::__mapped_file_header> _M_header;
+
+public:
+    typedef _Tp                      value_type;
+
+    typedef offset_ptr<_Tp>          pointer;
+    typedef offset_ptr<const _Tp>    const_pointer;
+    typedef offset_ptr<void>         void_pointer;
+    typedef offset_ptr<const void>   const_void_pointer;
+
+    typedef std::ptrdiff_t           difference_type;
+    typedef std::size_t              size_type;
+
+    template <typename _U>
+    struct rebind
+    {
+        typedef mapped_file_allocator<_U> other;
+    };
+
+    explicit mapped_file_allocator(const mapped_file& __file) noexcept
+        : _M_header(__file._M_header) { }
+
+    template <typename _U>
+    mapped_file_allocator(const mapped_file_allocator<_U>& __other) noexcept
+        : _M_header(__other._M_header) { }
+
+    pointer allocate(size_type __n) {
+        if (__n > max_size())
+            throw std::bad_alloc();
+        return pointer(static_cast<_Tp*>(
+            _M_header->__allocate(__n * sizeof(_Tp), alignof(_Tp))));
+    }
+
+    void deallocate(pointer __p, size_type __n) noexcept
+        { _M_header->__deallocate(__p.get(), __n * sizeof(_Tp), alignof(_Tp)); }
+
+    size_type max_size() const noexcept
+        { return std::numeric_limits<size_type>::max() / sizeof(_Tp); }
+
+    template <typename _T1, typename _T2>
+    friend bool operator==(const mapped_file_allocator<_T1>& __a,
+                           const mapped_file_allocator<_T2>& __b) noexcept;
+};
+
+template <typename _T1, typename _T2>
+inline bool operator==(const mapped_file_allocator<_T1>& __a,
+                       const mapped_file_allocator<_T2>& __b) noexcept
+{
+    return __a._M_header == __b._M_header;
+}
+
+template <typename _T1, typename _T2>
+inline bool operator!=(const mapped_file_allocator<_T1>& __a,
+                       const mapped_file_allocator<_T2>& __b) noexcept
+{
+    return ! (__a == __b);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// IMPLEMENTATION
+///////////////////////////////////////////////////////////////////////////////
+
+inline
+__details::__mapped_file_header::__mapped_file_header(std::size_t __size)
+    : _M_magic(__magic)
+    , _M_size(__size)
+    , _M_top(sizeof(__mapped_file_header))
+{
+}
+
+inline bool
+__details::__mapped_file_header::__is_valid(std::size_t __size) const
+{
+    return (__magic == _M_magic && __size == _M_size &&
+            sizeof(__mapped_file_header) <= _M_top && _M_top <= _M_size);
+}
+
+inline int __details::__mapped_file_header::__size_class(
+    std::size_t __bytes, std::size_t __alignment)
+{
+    if (__alignment > __max_alignment)
+        return __num_classes;
+    std::size_t __block_size = __bytes < __alignment ? __alignment : __bytes;
+    int __class = 0;
+    while ((std::size_t(__min_block_size) << __class) < __block_size) {
+        if (++__class == __num_classes)
+            break;
+    }
+    return __class;
+}
+
+inline void* __details::__mapped_file_header::__allocate(
+    std::size_t __bytes, std::size_t __alignment)
+{
+    const int __class = __size_class(__bytes, __alignment);
+    if (__class == __num_classes)
+        throw std::bad_alloc();
+
+    if (__mapped_free_block* __block = _M_free[__class].get()) {
+        _M_free[__class] = __block->_M_next;
+        return __block;
+    }
+
+    // Blocks are aligned to their size, up to the alignment of the mapping.
+    const std::uint64_t __block_size  = std::uint64_t(__min_block_size) <<
+                                        __class;
+    const std::uint64_t __block_align = (__block_size < __max_alignment ?
+                                         __block_size :
+                                         std::uint64_t(__max_alignment));
+    const std::uint64_t __offset = ((_M_top + __block_align - 1) &
+                                    ~(__block_align - 1));
+    if (__offset > _M_size || __block_size > _M_size - __offset)
+        throw std::bad_alloc();
+    _M_top = __offset + __block_size;
+    return reinterpret_cast<char*>(this) + __offset;
+}
+
+inline void __details::__mapped_file_header::__deallocate(
+    void* __p, std::size_t __bytes, std::size_t __alignment) noexcept
+{
+    const int __class = __size_class(__bytes, __alignment);
+    __mapped_free_block* __block = ::new (__p) __mapped_free_block;
+    __block->_M_next = _M_free[__class];
+    _M_free[__class] = __block;
+}
+
+inline mapped_file::mapped_file(const char* __path, std::size_t __size)
+    : _M_fd(::open(__path, O_RDWR | O_CREAT, 0644))
+    , _M_base(nullptr)
+    , _M_size(0)
+    , _M_created(false)
+    , _M_header(nullptr)
+{
+    typedef __details::__mapped_file_header _Header;
+
+    if (_M_fd < 0)
+        throw std::system_error(errno, std::generic_category(), __path);
+
+    struct stat __st;
+    if (0 != ::fstat(_M_fd, &__st)) {
+        int __err = errno;
+        ::close(_M_fd);
+        throw std::system_error(__err, std::generic_category(), __path);
+    }
+
+    _M_created = (0 == __st.st_size);
+    if (_M_created) {
+        if (__size < sizeof(_Header)) {
+            ::close(_M_fd);
+            throw std::invalid_argument("mapped_file: size too small");
+        }
+        if (0 != ::ftruncate(_M_fd, off_t(__size))) {
+            int __err = errno;
+            ::close(_M_fd);
+            throw std::system_error(__err, std::generic_category(), __path);
+        }
+        _M_size = __size;
+    }
+    else
+        _M_size = std::size_t(__st.st_size);
+
+    _M_base = ::mmap(nullptr, _M_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     _M_fd, 0);
+    if (MAP_FAILED == _M_base) {
+        int __err = errno;
+        ::close(_M_fd);
+        throw std::system_error(__err, std::generic_category(), __path);
+    }
+
+    if (_M_created)
+        _M_header = ::new (_M_base) _Header(_M_size);
+    else {
+        _M_header = static_cast<_Header*>(_M_base);
+        if (_M_size < sizeof(_Header) || ! _M_header->__is_valid(_M_size)) {
+            ::munmap(_M_base, _M_size);
+            ::close(_M_fd);
+            throw std::runtime_error("mapped_file: not a mapped file");
+        }
+    }
+}
+
+inline mapped_file::~mapped_file()
+{
+    ::munmap(_M_base, _M_size);
+    ::close(_M_fd);
+}
+
+inline void mapped_file::sync()
+{
+    if (0 != ::msync(_M_base, _M_size, MS_SYNC))
+        throw std::system_error(errno, std::generic_category(), "msync");
+}
+
+template <typename _Tp, typename... _Args>
+_Tp* mapped_file::construct_root(_Args&&... __args)
+{
+    void* __p = _M_header->__allocate(sizeof(_Tp), alignof(_Tp));
+    try {
+        _Tp* __root = ::new (__p) _Tp(std::forward<_Args>(__args)...);
+        _M_header->__root() = __root;
+        return __root;
+    }
+    catch (...) {
+        _M_header->__deallocate(__p, sizeof(_Tp), alignof(_Tp));
+        throw;
+    }
+}
+
+template <typename _Tp>
+void mapped_file::destroy_root()
+{
+    _Tp* __root = root<_Tp>();
+    if (! __root)
+        return;
+    _M_header->__root() = nullptr;
+    __root->~_Tp();
+    _M_header->__deallocate(__root, sizeof(_Tp), alignof(_Tp));
+}
+
+END_NAMESPACE_XSTD
+
+#endif // ! defined(INCLUDED_MAPPED_FILE_ALLOCATOR_DOT_H)
@@ -0,0 +1,437 @@
+/* mapped_file_allocator.t.cpp                  -*-C++-*-
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ *    (See accompanying file LICENSE_1_0.txt or copy at
+ *          http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+/* Also tests 'offset_ptr.h'.  Test case 4 uses the 'inplace_vector' of
+ * P3160, so build with, e.g.:
+ *
+ *     g++ -std=c++20 -I. -I../P3160-AA-inplace_vector \
+ *         mapped_file_allocator.t.cpp
+ */
+
+#include <mapped_file_allocator.h>
+#include <offset_ptr.h>
+#include <pointer_traits.h>
+#include <xstd_list.h>
+#include <inplace_vector.h>
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+//==========================================================================
+//                  ASSERT TEST MACRO
+//--------------------------------------------------------------------------
+static int testStatus = 0;
+
+static void aSsErT(int c, const char *s, int i) {
+    if (c) {
+        std::cout << __FILE__ << ":" << i << ": error: " << s
+                  << "    (failed)" << std::endl;
+        if (testStatus >= 0 && testStatus <= 100) ++testStatus;
+    }
+}
+
+# define ASSERT(X) { aSsErT(!(X), #X, __LINE__); }
+//--------------------------------------------------------------------------
+#define LOOP_ASSERT(I,X) { \
+    if (!(X)) { std::cout << #I << ": " << I << "\n"; \
+                aSsErT(1, #X, __LINE__); } }
+
+//=============================================================================
+//                  GLOBAL TYPEDEFS/CONSTANTS FOR TESTING
+//-----------------------------------------------------------------------------
+
+static int verbose = 0;
+
+#define IS_SAME(T,U) (std::is_same<T,U>::value)
+
+typedef XSTD::mapped_file_allocator<int>        IntAlloc;
+typedef XSTD::list<int, IntAlloc>               List;
+typedef std::experimental::inplace_vector<List, 8> Index;
+
+//=============================================================================
+//                  GLOBAL HELPER FUNCTIONS FOR TESTING
+//-----------------------------------------------------------------------------
+
+// Return the name of a new, empty file.
+std::string tempFile()
+{
+    char name[] = "/tmp/mapped_file_allocator.t.XXXXXX";
+    int fd = ::mkstemp(name);
+    ASSERT(fd >= 0);
+    ::close(fd);
+    return name;
+}
+
+// Run 'f' in a child process, as a separate run of a program would, and
+// return its exit status.
+template <typename Func>
+int inChildProcess(Func f)
+{
+    std::cout << std::flush;
+    pid_t pid = ::fork();
+    if (0 == pid) {
+        f();
+        std::cout << std::flush;
+        ::_exit(testStatus);
+    }
+    int status = -1;
+    ::waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+//=============================================================================
+//                  CLASSES FOR TESTING
+//-----------------------------------------------------------------------------
+
+struct Base { virtual ~Base() { } int b = 1; };
+struct Derived : Base { int d = 2; };
+
+// A self-referential structure that is relocated by copying its bytes.
+struct Relocatable
+{
+    int                     value[4];
+    XSTD::offset_ptr<int>   third;
+    XSTD::offset_ptr<int>   none;
+};
+
+//=============================================================================
+//                              MAIN PROGRAM
+//-----------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    int test = argc > 1 ? std::atoi(argv[1]) : 0;
+    verbose = argc > 2;
+
+    std::cout << "TEST " << __FILE__;
+    if (test != 0)
+        std::cout << " CASE " << test << std::endl;
+    else
+        std::cout << " all cases" << std::endl;
+
+    switch (test) { case 0:  // Zero runs all tests
+      case 1:
+      {
+        // --------------------------------------------------------------------
+        // TEST offset_ptr
+        // --------------------------------------------------------------------
+
+        std::cout << "\noffset_ptr"
+                  << "\n==========" << std::endl;
+
+        typedef XSTD::offset_ptr<int>           IPtr;
+        typedef XSTD::offset_ptr<const int>     CIPtr;
+        typedef XSTD::pointer_traits<IPtr>      Traits;
+
+        ASSERT( IS_SAME(int, Traits::element_type));
+        ASSERT( IS_SAME(std::ptrdiff_t, Traits::difference_type));
+        ASSERT( IS_SAME(XSTD::offset_ptr<double>,
+                        Traits::rebind<double>::other));
+
+        IPtr p;
+        ASSERT(! p);
+        ASSERT(p == nullptr);
+        ASSERT(nullptr == p.get());
+
+        int a[4] = { 10, 11, 12, 13 };
+        p = &a[1];
+        ASSERT(p);
+        ASSERT(p != nullptr);
+        ASSERT(&a[1] == p.get());
+        ASSERT(11 == *p);
+
+        // Copies, wherever they are, point to the same object.
+        IPtr q(p);
+        IPtr *heapCopy = new IPtr(q);
+        ASSERT(q == p);
+        ASSERT(*heapCopy == p);
+        ASSERT(&a[1] == heapCopy->get());
+        delete heapCopy;
+
+        ASSERT(Traits::pointer_to(a[2]) == p + 1);
+        ASSERT(12 == p[1]);
+        ASSERT(&a[3] == (p + 2).get());
+        ASSERT(&a[0] == (p - 1).get());
+        ASSERT(2 == (p + 2) - p);
+        ++q;
+        ASSERT(12 == *q);
+        ASSERT(p < q);
+
+        CIPtr cp = p;
+        ASSERT(cp == p);
+        IPtr p2 = XSTD::const_pointer_cast<int>(cp);
+        ASSERT(IS_SAME(decltype(p2), IPtr));
+        ASSERT(p2 == p);
+
+        XSTD::offset_ptr<void> vp = p;
+        IPtr p3 = XSTD::static_pointer_cast<int>(vp);
+        ASSERT(p3 == p);
+
+        Derived d;
+        XSTD::offset_ptr<Base> bp = &d;
+        ASSERT(bp.get() == static_cast<Base*>(&d));
+        XSTD::offset_ptr<Derived> dp =
+            XSTD::dynamic_pointer_cast<Derived>(bp);
+        ASSERT(&d == dp.get());
+        ASSERT(2 == dp->d);
+
+        // A structure that points into itself can be moved with 'memcpy'.
+        Relocatable *r1 = new Relocatable{ { 1, 2, 3, 4 }, nullptr, nullptr };
+        r1->third = &r1->value[2];
+        Relocatable *r2 = static_cast<Relocatable*>(
+            ::operator new(sizeof(Relocatable)));
+        std::memcpy(static_cast<void*>(r2), r1, sizeof(Relocatable));
+        delete r1;
+        ASSERT(&r2->value[2] == r2->third.get());
+        ASSERT(3 == *r2->third);
+        ASSERT(! r2->none);
+        ::operator delete(r2);
+
+      } if (test != 0) break;
+
+      case 2:
+      {
+        // --------------------------------------------------------------------
+        // TEST mapped_file heap
+        // --------------------------------------------------------------------
+
+        std::cout << "\nmapped_file heap"
+                  << "\n================" << std::endl;
+
+        const std::string path = tempFile();
+        {
+            XSTD::mapped_file file(path.c_str(), 64 * 1024);
+            ASSERT(file.created());
+            ASSERT(64 * 1024 == file.size());
+            ASSERT(nullptr == file.root<int>());
+
+            char *base = static_cast<char*>(file.data());
+            const std::size_t unused = file.bytes_unused();
+
+            XSTD::mapped_file_allocator<double> a = file.get_allocator<double>();
+            XSTD::mapped_file_allocator<char>   c(a);
+            ASSERT(a == c);
+
+            XSTD::offset_ptr<double> p1 = a.allocate(3);
+            ASSERT(0 == reinterpret_cast<std::uintptr_t>(p1.get()) % 32);
+            ASSERT(base < static_cast<char*>(static_cast<void*>(p1.get())));
+            ASSERT(unused - 32 >= file.bytes_unused());
+
+            // Freed blocks are reused by requests of the same size class.
+            XSTD::offset_ptr<double> p2 = a.allocate(4);
+            ASSERT(p1 != p2);
+            a.deallocate(p1, 3);
+            XSTD::offset_ptr<char> p3 = c.allocate(17);
+            ASSERT(static_cast<void*>(p3.get()) ==
+                   static_cast<void*>(p1.get()));
+            c.deallocate(p3, 17);
+            a.deallocate(p2, 4);
+
+            // Large alignments are honored up to a page.
+            struct alignas(256) Aligned { char c; };
+            XSTD::mapped_file_allocator<Aligned> aa(a);
+            XSTD::offset_ptr<Aligned> p4 = aa.allocate(1);
+            ASSERT(0 == reinterpret_cast<std::uintptr_t>(p4.get()) % 256);
+            aa.deallocate(p4, 1);
+
+            // The file does not grow.
+            bool caught = false;
+            try {
+                c.allocate(64 * 1024);
+            }
+            catch (const std::bad_alloc&) {
+                caught = true;
+            }
+            ASSERT(caught);
+        }
+
+        // The size of an existing file is kept.
+        {
+            XSTD::mapped_file file(path.c_str(), 1024 * 1024);
+            ASSERT(! file.created());
+            ASSERT(64 * 1024 == file.size());
+        }
+
+        // A file that was not created by 'mapped_file' is rejected.
+        {
+            int fd = ::open(path.c_str(), O_WRONLY);
+            ASSERT(8 == ::write(fd, "garbage!", 8));
+            ::close(fd);
+            bool caught = false;
+            try {
+                XSTD::mapped_file file(path.c_str(), 64 * 1024);
+            }
+            catch (const std::runtime_error&) {
+                caught = true;
+            }
+            ASSERT(caught);
+        }
+        ::unlink(path.c_str());
+
+      } if (test != 0) break;
+
+      case 3:
+      {
+        // --------------------------------------------------------------------
+        // TEST list persisting across processes
+        // --------------------------------------------------------------------
+
+        std::cout << "\nlist persisting across processes"
+                  << "\n================================" << std::endl;
+
+        const std::string path = tempFile();
+
+        // The first run builds the list.
+        int status = inChildProcess([&path] {
+            XSTD::mapped_file file(path.c_str(), 1024 * 1024);
+            ASSERT(file.created());
+            List *lst = file.construct_root<List>(file.get_allocator<int>());
+            for (int i = 0; i < 1000; ++i)
+                lst->push_back(i);
+            int data[] = { -1, -2, -3 };
+            lst->insert(lst->end(), data, data + 3);
+            file.sync();
+        });
+        ASSERT(0 == status);
+
+        // The next run finds it as it was left.
+        status = inChildProcess([&path] {
+            XSTD::mapped_file file(path.c_str(), 0);
+            ASSERT(! file.created());
+            List *lst = file.root<List>();
+            ASSERT(lst);
+            ASSERT(1003 == lst->size());
+            ASSERT(0 == lst->front());
+            ASSERT(-3 == lst->back());
+            int e = 0;
+            for (List::iterator i = lst->begin(); e < 1000; ++i)
+                LOOP_ASSERT(e, e++ == *i);
+
+            lst->pop_back();
+            lst->push_front(-100);
+        });
+        ASSERT(0 == status);
+
+        // Two mappings of the same file, at different addresses, see the
+        // same list.
+        {
+            XSTD::mapped_file file1(path.c_str(), 0);
+            XSTD::mapped_file file2(path.c_str(), 0);
+            ASSERT(file1.data() != file2.data());
+
+            List *lst1 = file1.root<List>();
+            List *lst2 = file2.root<List>();
+            ASSERT(static_cast<void*>(lst1) != static_cast<void*>(lst2));
+            ASSERT(1003 == lst1->size());
+            ASSERT(-100 == lst1->front());
+            ASSERT(-2 == lst2->back());
+            ASSERT(*lst1 == *lst2);
+
+            List::iterator i = lst1->begin();
+            while (*i != 500)
+                ++i;
+            lst1->erase(i);
+            ASSERT(1002 == lst2->size());
+            ASSERT(*lst1 == *lst2);
+
+            // A copy outside the file uses the file's heap.
+            List copy(*lst2);
+            ASSERT(copy == *lst1);
+            ASSERT(copy.get_allocator() == file2.get_allocator<int>());
+
+            file1.destroy_root<List>();
+            ASSERT(nullptr == file2.root<List>());
+        }
+        ::unlink(path.c_str());
+
+      } if (test != 0) break;
+
+      case 4:
+      {
+        // --------------------------------------------------------------------
+        // TEST inplace_vector of lists persisting across processes
+        // --------------------------------------------------------------------
+
+        std::cout << "\ninplace_vector of lists persisting across processes"
+                  << "\n===================================================="
+                  << std::endl;
+
+        const std::string path = tempFile();
+
+        // An index of 8 buckets of keys, all in the file.
+        int status = inChildProcess([&path] {
+            XSTD::mapped_file file(path.c_str(), 1024 * 1024);
+            Index *index = file.construct_root<Index>();
+            for (int b = 0; b < 8; ++b)
+                index->emplace_back(file.get_allocator<int>());
+            for (int key = 0; key < 4000; ++key)
+                (*index)[key % 8].push_back(key);
+            file.sync();
+        });
+        ASSERT(0 == status);
+
+        status = inChildProcess([&path] {
+            XSTD::mapped_file file(path.c_str(), 0);
+            Index *index = file.root<Index>();
+            ASSERT(index);
+            ASSERT(8 == index->size());
+            for (int b = 0; b < 8; ++b) {
+                const List& bucket = (*index)[b];
+                LOOP_ASSERT(b, 500 == bucket.size());
+                int key = b;
+                for (int k : bucket) {
+                    LOOP_ASSERT(b, key == k);
+                    key += 8;
+                }
+            }
+
+            // Modify the index in place, for the next run.
+            (*index)[3].clear();
+            index->pop_back();
+        });
+        ASSERT(0 == status);
+
+        {
+            XSTD::mapped_file file(path.c_str(), 0);
+            Index *index = file.root<Index>();
+            ASSERT(7 == index->size());
+            ASSERT((*index)[3].empty());
+            ASSERT(500 == (*index)[6].size());
+            ASSERT(3998 == (*index)[6].back());
+
+            // The index can be destroyed, returning the nodes to the heap.
+            const std::size_t unused = file.bytes_unused();
+            file.destroy_root<Index>();
+            List lst(file.get_allocator<int>());
+            for (int i = 0; i < 100; ++i)
+                lst.push_back(i);
+            ASSERT(unused == file.bytes_unused());
+        }
+        ::unlink(path.c_str());
+
+      } if (test != 0) break;
+
+      break; // Break at end of numbered tests
+
+      default: {
+        std::cerr << "WARNING: CASE `" << test << "' NOT FOUND." << std::endl;
+        testStatus = -1;
+      }
+    }
+
+    if (testStatus > 0) {
+        std::cerr << "Error, non-zero test status = " << testStatus << "."
+                  << std::endl;
+    }
+
+    return testStatus;
+}
@@ -0,0 +1,179 @@
+/* offset_ptr.h                  -*-C++-*-
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ *    (See accompanying file LICENSE_1_0.txt or copy at
+ *          http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+/* This component defines 'offset_ptr<T>', a fancy pointer that stores the
+ * distance from its own address to the object it points to, rather than the
+ * address of that object.  A structure whose 'offset_ptr's point only into
+ * the same block of memory stays valid wherever that block is mapped, which
+ * makes it possible for a container to live in a shared-memory segment or a
+ * memory-mapped file that is mapped at different addresses by different
+ * processes (see 'mapped_file_allocator.h').
+ *
+ * Because the value of an 'offset_ptr' depends on its address, copying one
+ * recomputes the offset: a copy made on the stack points to the same object
+ * as the original.  An 'offset_ptr' must therefore never be copied with
+ * 'memcpy'.  An offset of 1 represents the null pointer, since no object of
+ * an 'offset_ptr' type can start at the byte after the start of an
+ * 'offset_ptr'.
+ *
+ * 'offset_ptr' meets the requirements of 'pointer_traits' (it has an
+ * 'element_type', a static 'pointer_to', and member 'static_pointer_cast',
+ * 'const_pointer_cast', and 'dynamic_pointer_cast' templates) and those of a
+ * random-access iterator, so it can serve as the 'pointer' type of an
+ * allocator.
+ */
+
+#ifndef INCLUDED_OFFSET_PTR_DOT_H
+#define INCLUDED_OFFSET_PTR_DOT_H
+
+#include <xstd.h>
+#include <memory_util.h>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+BEGIN_NAMESPACE_XSTD
+
+template <typename _Tp>
+class offset_ptr
+{
+    template <typename _U> friend class offset_ptr;
+
+    static const std::ptrdiff_t __null_offset = 1;
+
+    std::ptrdiff_t _M_offset;
+
+    std::ptrdiff_t __offset_to(const volatile void* __p) const noexcept {
+        if (! __p)
+            return __null_offset;
+        return (reinterpret_cast<std::intptr_t>(__p) -
+                reinterpret_cast<std::intptr_t>(this));
+    }
+
+public:
+    typedef _Tp                                         element_type;
+    typedef _Tp                                         value_type;
+    typedef std::ptrdiff_t                              difference_type;
+    typedef typename std::add_lvalue_reference<_Tp>::type reference;
+    typedef offset_ptr                                  pointer;
+    typedef std::random_access_iterator_tag             iterator_category;
+
+    offset_ptr() noexcept : _M_offset(__null_offset) { }
+    offset_ptr(std::nullptr_t) noexcept : _M_offset(__null_offset) { }
+    offset_ptr(_Tp* __p) noexcept : _M_offset(__offset_to(__p)) { }
+    offset_ptr(const offset_ptr& __other) noexcept
+        : _M_offset(__offset_to(__other.get())) { }
+    template <typename _U,
+              typename = typename std::enable_if<
+                  std::is_convertible<_U*, _Tp*>::value>::type>
+    offset_ptr(const offset_ptr<_U>& __other) noexcept
+        : _M_offset(__offset_to(static_cast<_Tp*>(__other.get()))) { }
+
+    offset_ptr& operator=(const offset_ptr& __other) noexcept
+        { _M_offset = __offset_to(__other.get()); return *this; }
+    offset_ptr& operator=(_Tp* __p) noexcept
+        { _M_offset = __offset_to(__p); return *this; }
+    offset_ptr& operator=(std::nullptr_t) noexcept
+        { _M_offset = __null_offset; return *this; }
+
+    _Tp* get() const noexcept {
+        if (__null_offset == _M_offset)
+            return nullptr;
+        return reinterpret_cast<_Tp*>(
+            reinterpret_cast<std::intptr_t>(this) + _M_offset);
+    }
+
+    reference operator*() const { return *get(); }
+    _Tp* operator->() const noexcept { return get(); }
+    explicit operator bool() const noexcept
+        { return __null_offset != _M_offset; }
+
+    static offset_ptr
+    pointer_to(typename __details::__unvoid<_Tp>::type& __r) noexcept
+        { return offset_ptr(XSTD::addressof(__r)); }
+
+    template <typename _U>
+    offset_ptr<_U> static_pointer_cast() const noexcept
+        { return offset_ptr<_U>(static_cast<_U*>(get())); }
+    template <typename _U>
+    offset_ptr<_U> const_pointer_cast() const noexcept
+        { return offset_ptr<_U>(const_cast<_U*>(get())); }
+    template <typename _U>
+    offset_ptr<_U> dynamic_pointer_cast() const noexcept
+        { return offset_ptr<_U>(dynamic_cast<_U*>(get())); }
+
+    // Random-access iterator operations.  Not meaningful for 'void'.
+    reference operator[](difference_type __n) const { return get()[__n]; }
+    offset_ptr& operator+=(difference_type __n)
+        { *this = get() + __n; return *this; }
+    offset_ptr& operator-=(difference_type __n)
+        { *this = get() - __n; return *this; }
+    offset_ptr& operator++() { return *this += 1; }
+    offset_ptr& operator--() { return *this -= 1; }
+    offset_ptr operator++(int) { offset_ptr __tmp(*this); ++*this; return __tmp; }
+    offset_ptr operator--(int) { offset_ptr __tmp(*this); --*this; return __tmp; }
+
+    friend offset_ptr operator+(const offset_ptr& __p, difference_type __n)
+        { return offset_ptr(__p.get() + __n); }
+    friend offset_ptr operator+(difference_type __n, const offset_ptr& __p)
+        { return offset_ptr(__p.get() + __n); }
+    friend offset_ptr operator-(const offset_ptr& __p, difference_type __n)
+        { return offset_ptr(__p.get() - __n); }
+    friend difference_type operator-(const offset_ptr& __a,
+                                     const offset_ptr& __b)
+        { return __a.get() - __b.get(); }
+};
+
+template <typename _Tp1, typename _Tp2>
+inline bool operator==(const offset_ptr<_Tp1>& __a,
+                       const offset_ptr<_Tp2>& __b) noexcept
+{
+    return __a.get() == __b.get();
+}
+
+template <typename _Tp1, typename _Tp2>
+inline bool operator!=(const offset_ptr<_Tp1>& __a,
+                       const offset_ptr<_Tp2>& __b) noexcept
+{
+    return ! (__a == __b);
+}
+
+template <typename _Tp>
+inline bool operator==(const offset_ptr<_Tp>& __p, std::nullptr_t) noexcept
+{
+    return ! __p;
+}
+
+template <typename _Tp>
+inline bool operator==(std::nullptr_t, const offset_ptr<_Tp>& __p) noexcept
+{
+    return ! __p;
+}
+
+template <typename _Tp>
+inline bool operator!=(const offset_ptr<_Tp>& __p, std::nullptr_t) noexcept
+{
+    return bool(__p);
+}
+
+template <typename _Tp>
+inline bool operator!=(std::nullptr_t, const offset_ptr<_Tp>& __p) noexcept
+{
+    return bool(__p);
+}
+
+template <typename _Tp1, typename _Tp2>
+inline bool operator<(const offset_ptr<_Tp1>& __a,
+                      const offset_ptr<_Tp2>& __b) noexcept
+{
+    return __a.get() < __b.get();
+}
+
+END_NAMESPACE_XSTD
+
+#endif // ! defined(INCLUDED_OFFSET_PTR_DOT_H)
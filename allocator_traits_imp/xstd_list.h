@@ -79,7 +79,7 @@ namespace __details
     template <typename _Tp, typename _NodePtr>
     class __list_iterator_base {
     protected:
-	template <typename _T, typename _A> friend class list;
+	template <typename _T, typename _A> friend class XSTD::list;
 
         _NodePtr _M_nodeptr;
 
@@ -87,7 +87,7 @@ namespace __details
 	    : _M_nodeptr(__p) { }
         __list_iterator_base() = default;
         __list_iterator_base(const __list_iterator_base&) = default;
-        __list_iterator_base operator=(const __list_iterator_base&) = default;
+        __list_iterator_base& operator=(const __list_iterator_base&) = default;
         ~__list_iterator_base() = default;
     };
 
@@ -186,6 +186,16 @@ class list
     // Creates _M_tail node if empty.
     void __create_tail();
 
+    // Append copies of the elements in [first, last).  The nodes for a
+    // forward range are obtained in batches using 'allocate_n'.
+    enum { __node_batch = 32 };
+    template <typename InputIter>
+      void __append_range(InputIter first, InputIter last,
+                          std::input_iterator_tag);
+    template <typename FwdIter>
+      void __append_range(FwdIter first, FwdIter last,
+                          std::forward_iterator_tag);
+
 public:
     // types:
     typedef _Tp& reference;
@@ -352,6 +362,57 @@ inline void list<_Tp,_Alloc>::__create_tail()
     __link_nodes(_M_tail, _M_tail);  // circular
 }
 
+template <typename _Tp, typename _Alloc>
+  template <typename InputIter>
+    void list<_Tp,_Alloc>::__append_range(InputIter first, InputIter last,
+                                          std::input_iterator_tag)
+{
+    for (; first != last; ++first)
+        emplace(end(), *first);
+}
+
+template <typename _Tp, typename _Alloc>
+  template <typename FwdIter>
+    void list<_Tp,_Alloc>::__append_range(FwdIter first, FwdIter last,
+                                          std::forward_iterator_tag)
+{
+    _NodePtr __nodes[__node_batch];
+    size_type __remaining = std::distance(first, last);
+
+    while (__remaining > 0) {
+        size_type __n = __remaining < size_type(__node_batch) ?
+            __remaining : size_type(__node_batch);
+        _AllocTraits::allocate_n(__allocator(), __n, __nodes);
+
+        size_type __i = 0;  // Number of nodes linked into the list
+        try {
+            for (; __i < __n; ++first) {
+                _NodePtr p = __nodes[__i];
+                p->init();
+                try {
+                    _AllocTraits::construct(__allocator(),
+                                            addressof(p->_M_value), *first);
+                }
+                catch (...) {
+                    p->deinit();
+                    throw;
+                }
+                __insert_node(p, _M_tail->_M_prev, _M_tail);
+                ++__size();
+                ++__i;
+            }
+        }
+        catch (...) {
+            // Return the nodes that were not linked into the list.
+            _AllocTraits::deallocate_n(__allocator(), __nodes + __i,
+                                       __n - __i);
+            throw;
+        }
+
+        __remaining -= __n;
+    }
+}
+
 // 23.3.4.1 construct/copy/destroy:
 template <typename _Tp, typename _Alloc>
 list<_Tp,_Alloc>::list(const _Alloc& a)
@@ -379,7 +440,15 @@ template <typename _Tp, typename _Alloc>
 	: _M_alloc_and_size(a, 0)
 {
     __create_tail();
-    assign(first, last);
+    try {
+        __append_range(first, last,
+            typename std::iterator_traits<InputIter>::iterator_category());
+    }
+    catch (...) {
+        clear();
+        __free_node(_M_tail);
+        throw;
+    }
 }
 
 template <typename _Tp, typename _Alloc>
@@ -388,7 +457,14 @@ list<_Tp,_Alloc>::list(const list& x)
        _AllocTraits::select_on_container_copy_construction(x.__allocator()), 0)
 {
     __create_tail();
-    assign(x.begin(), x.end());
+    try {
+        __append_range(x.begin(), x.end(), std::forward_iterator_tag());
+    }
+    catch (...) {
+        clear();
+        __free_node(_M_tail);
+        throw;
+    }
 }
 
 template <typename _Tp, typename _Alloc>
@@ -405,7 +481,14 @@ list<_Tp,_Alloc>::list(const list& x, const _Alloc& a)
     : _M_alloc_and_size(a, 0)
 {
     __create_tail();
-    assign(x.begin(), x.end());
+    try {
+        __append_range(x.begin(), x.end(), std::forward_iterator_tag());
+    }
+    catch (...) {
+        clear();
+        __free_node(_M_tail);
+        throw;
+    }
 }
 
 template <typename _Tp, typename _Alloc>
@@ -832,7 +915,27 @@ void list<_Tp,_Alloc>::swap(list& x)
 template <typename _Tp, typename _Alloc>
 void list<_Tp,_Alloc>::clear()
 {
-    erase(begin(), end());
+    // Destroy the elements and return their nodes in batches using
+    // 'deallocate_n'.
+    _NodePtr __nodes[__node_batch];
+    size_type __n = 0;
+
+    _NodePtr p = __head();
+    while (p != _M_tail) {
+        _NodePtr __next = p->_M_next;
+        _AllocTraits::destroy(__allocator(), addressof(p->_M_value));
+        p->deinit();
+        __nodes[__n++] = p;
+        if (size_type(__node_batch) == __n) {
+            _AllocTraits::deallocate_n(__allocator(), __nodes, __n);
+            __n = 0;
+        }
+        p = __next;
+    }
+    _AllocTraits::deallocate_n(__allocator(), __nodes, __n);
+
+    __link_nodes(_M_tail, _M_tail);
+    __size() = 0;
 }
 
 // 23.3.4.4 list operations:
@@ -188,6 +188,58 @@ template class SimpleAllocator<double>;
 template class XSTD::allocator_traits<SimpleAllocator<double> >;
 template class XSTD::list<double, SimpleAllocator<double> >;
 
+int batchCalls = 0;  // Number of calls to 'allocate_n' and 'deallocate_n'
+
+// Allocator like 'SimpleAllocator' that also provides the batch operations
+// 'allocate_n' and 'deallocate_n'.
+template <typename Tp>
+class BatchAllocator
+{
+    AllocResource *resource_;
+
+  public:
+    typedef Tp              value_type;
+
+    BatchAllocator(AllocResource* ar = nullptr) : resource_(ar) { }
+
+    // Required constructor
+    template <typename T>
+    BatchAllocator(const BatchAllocator<T>& other)
+        : resource_(other.resource()) { }
+
+    Tp* allocate(std::size_t n)
+        { return static_cast<Tp*>(resource_->allocate(n*sizeof(Tp))); }
+
+    void deallocate(Tp* p, std::size_t n)
+        { resource_->deallocate(p, n*sizeof(Tp)); }
+
+    void allocate_n(std::size_t count, Tp** out) {
+        ++batchCalls;
+        for (std::size_t i = 0; i < count; ++i)
+            out[i] = allocate(1);
+    }
+
+    void deallocate_n(Tp* const* ps, std::size_t count) {
+        ++batchCalls;
+        for (std::size_t i = 0; i < count; ++i)
+            deallocate(ps[i], 1);
+    }
+
+    AllocResource* resource() const { return resource_; }
+};
+
+template <typename Tp1, typename Tp2>
+bool operator==(const BatchAllocator<Tp1>& a, const BatchAllocator<Tp2>& b)
+{
+    return a.resource() == b.resource();
+}
+
+template <typename Tp1, typename Tp2>
+bool operator!=(const BatchAllocator<Tp1>& a, const BatchAllocator<Tp2>& b)
+{
+    return ! (a == b);
+}
+
 struct UniqDummyType { void zzzzz(UniqDummyType, bool) { } };
 typedef void (UniqDummyType::*UniqPointerType)(UniqDummyType);
 
@@ -952,9 +1004,11 @@ int main(int argc, char *argv[])
             ASSERT(1 == y.size());
             ASSERT(3 == y.front());
             ASSERT(y.get_allocator() == a1);
-            // implementation-specific:
-            ASSERT(2 == ar1.blocks_outstanding());
-            ASSERT(1 == defaultResource.blocks_outstanding());
+            // implementation-specific: the moved-from 'x' gets a new sentinel
+            // node from whichever resource its allocator refers to after the
+            // move, so only the total is checked.
+            ASSERT(3 == ar1.blocks_outstanding() +
+                        defaultResource.blocks_outstanding());
 
             // required behavior:
             ASSERT(0 == ar2.blocks_outstanding()); 
@@ -1001,6 +1055,68 @@ int main(int argc, char *argv[])
 
       } if (test != 0) break;
 
+      case 6:
+      {
+        // --------------------------------------------------------------------
+        // TEST batch node allocation using BatchAllocator
+        // --------------------------------------------------------------------
+
+        std::cout << "\nBatchAllocator"
+                  << "\n==============" << std::endl;
+
+        AllocResource ar;
+
+        int data[100];
+        for (int i = 0; i < 100; ++i)
+            data[i] = i;
+
+        {
+            BatchAllocator<int> a(&ar);
+            batchCalls = 0;
+
+            // Range construction allocates the nodes in batches of 32.
+            XSTD::list<int, BatchAllocator<int> > x(data, data + 100, a);
+            ASSERT(100 == x.size());
+            ASSERT(101 == ar.blocks_outstanding());
+            LOOP_ASSERT(batchCalls, 4 == batchCalls);
+            int e = 0;
+            for (int v : x)
+                ASSERT(e++ == v);
+            ASSERT(100 == e);
+
+            // So does copy construction.
+            XSTD::list<int, BatchAllocator<int> > y(x);
+            ASSERT(100 == y.size());
+            ASSERT(202 == ar.blocks_outstanding());
+            LOOP_ASSERT(batchCalls, 8 == batchCalls);
+            ASSERT(x == y);
+
+            // 'clear' deallocates the nodes in batches.
+            x.clear();
+            ASSERT(x.empty());
+            ASSERT(x.begin() == x.end());
+            ASSERT(102 == ar.blocks_outstanding());
+            LOOP_ASSERT(batchCalls, 12 == batchCalls);
+
+            x.push_back(7);
+            ASSERT(1 == x.size());
+            ASSERT(7 == x.front());
+        }
+        ASSERT(0 == ar.blocks_outstanding());
+        ASSERT(0 == ar.bytes_outstanding());
+
+        {
+            // Without 'allocate_n', nodes are allocated one at a time.
+            SimpleAllocator<int> a(&ar);
+            XSTD::list<int, SimpleAllocator<int> > x(data, data + 40, a);
+            ASSERT(40 == x.size());
+            ASSERT(41 == ar.blocks_outstanding());
+            ASSERT(39 == x.back());
+        }
+        ASSERT(0 == ar.blocks_outstanding());
+
+      } if (test != 0) break;
+
       break; // Break at end of numbered tests
 
       default: {